@@ -0,0 +1,478 @@
+// Microbenchmarks for the simulation hot paths. Every case sweeps one size
+// parameter from a fixed seed and reports the time per operation and per
+// item; --json writes the same results for scripts comparing two builds.
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "animal.hpp"
+#include "buildings.hpp"
+#include "collectables.hpp"
+#include "frustum.hpp"
+#include "input.hpp"
+#include "pen_tracker.hpp"
+#include "physics.hpp"
+#include "player.hpp"
+#include "rope_system.hpp"
+#include "simulation.hpp"
+#include "terrain.hpp"
+#include "tube_batch.hpp"
+#include "utils.hpp"
+
+struct BenchOptions {
+  const char* filter = nullptr;  // Only cases whose name contains this
+  const char* json = nullptr;    // Also write results here
+  double minTime = 0.25;         // Seconds of timed work per measurement
+  int maxAnimals = 1 << 20;
+  int maxPens = 1000;
+  int threads = 0;
+  uint64_t seed = 1;
+};
+
+struct BenchResult {
+  std::string name;
+  std::string param;  // Name of the swept parameter
+  long long value;
+  uint64_t iterations;
+  double nsPerOp;
+  double itemsPerSecond;
+};
+
+static void print_usage(const char* program) {
+  printf(
+      "usage: %s [--filter NAME] [--json FILE] [--min-time S]\n"
+      "          [--max-animals N] [--max-pens N] [--threads N] [--seed N]\n"
+      "  Times the simulation hot paths over parameter sweeps. Results for\n"
+      "  equal options are comparable between builds.\n",
+      program);
+}
+
+static bool parse_options(int argc, char** argv, BenchOptions& options) {
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    if (i + 1 >= argc) {
+      return false;
+    }
+    const char* value = argv[++i];
+    if (strcmp(arg, "--filter") == 0) {
+      options.filter = value;
+    } else if (strcmp(arg, "--json") == 0) {
+      options.json = value;
+    } else if (strcmp(arg, "--min-time") == 0) {
+      options.minTime = strtod(value, nullptr);
+    } else if (strcmp(arg, "--max-animals") == 0) {
+      options.maxAnimals = static_cast<int>(strtol(value, nullptr, 10));
+    } else if (strcmp(arg, "--max-pens") == 0) {
+      options.maxPens = static_cast<int>(strtol(value, nullptr, 10));
+    } else if (strcmp(arg, "--threads") == 0) {
+      options.threads = static_cast<int>(strtol(value, nullptr, 10));
+    } else if (strcmp(arg, "--seed") == 0) {
+      options.seed = strtoull(value, nullptr, 10);
+    } else {
+      return false;
+    }
+  }
+  return options.minTime > 0.0 && options.maxAnimals > 0 &&
+         options.maxPens > 0 && options.threads >= 0;
+}
+
+class Bench {
+ public:
+  explicit Bench(const BenchOptions& options) : options(options) {}
+
+  bool enabled(const char* name) const {
+    return !options.filter || strstr(name, options.filter);
+  }
+
+  // Time `body` until minTime seconds of it have run (at least twice after
+  // one warm-up call). `setup` runs untimed before every call, to put the
+  // state back where the body expects it.
+  void run(const char* name,
+           const char* param,
+           long long value,
+           double itemsPerOp,
+           const std::function<void()>& setup,
+           const std::function<void()>& body) {
+    setup();
+    body();
+    double seconds = 0.0;
+    uint64_t iterations = 0;
+    while (seconds < options.minTime || iterations < 2) {
+      setup();
+      auto start = std::chrono::steady_clock::now();
+      body();
+      auto end = std::chrono::steady_clock::now();
+      seconds += std::chrono::duration<double>(end - start).count();
+      iterations++;
+    }
+    BenchResult result;
+    result.name = name;
+    result.param = param;
+    result.value = value;
+    result.iterations = iterations;
+    result.nsPerOp = 1e9 * seconds / iterations;
+    result.itemsPerSecond = itemsPerOp * iterations / seconds;
+    printf("%-24s %10s=%-8lld %10llu %14.0f %14.3e\n", name, param, value,
+           static_cast<unsigned long long>(iterations), result.nsPerOp,
+           result.itemsPerSecond);
+    fflush(stdout);
+    results.push_back(result);
+  }
+
+  bool write_json(const char* path, int threads) const {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+      return false;
+    }
+    fprintf(file, "{\n  \"context\": {\"seed\": %llu, \"threads\": %d},\n",
+            static_cast<unsigned long long>(options.seed), threads);
+    fprintf(file, "  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+      const BenchResult& r = results[i];
+      fprintf(file,
+              "    {\"name\": \"%s\", \"params\": {\"%s\": %lld}, "
+              "\"iterations\": %llu, \"ns_per_op\": %.1f, "
+              "\"items_per_second\": %.6e}%s\n",
+              r.name.c_str(), r.param.c_str(), r.value,
+              static_cast<unsigned long long>(r.iterations), r.nsPerOp,
+              r.itemsPerSecond, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    return fclose(file) == 0;
+  }
+
+  const BenchOptions& options;
+
+ private:
+  std::vector<BenchResult> results;
+};
+
+// Make `value`, and so the work that produced it, look used to the
+// optimizer without printing or storing it anywhere
+template <typename T>
+static void do_not_optimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  const volatile char* sink = reinterpret_cast<const volatile char*>(&value);
+  (void)*sink;
+#endif
+}
+
+// Herd spread at the density of the default 50x50 spawn area
+static float spawn_extent(int animals) {
+  return std::max(25.0f, 25.0f * std::sqrt(animals / 1000.0f));
+}
+
+static void spawn_herd(GameState& GameState, int animals) {
+  GameState.animals->clear();
+  spawn_animals(*GameState.animals, GameState.spawnRandom, animals,
+                spawn_extent(animals));
+  GameState.addAnimalInterval = 1e30f;
+}
+
+// Closed regular polygon (first point repeated, like Fence::place)
+static std::vector<vec3> regular_polygon(float cx,
+                                         float cz,
+                                         float radius,
+                                         int sides) {
+  std::vector<vec3> points;
+  for (int i = 0; i <= sides; i++) {
+    float angle = 2.0f * PI * (i % sides) / sides;
+    points.push_back(vec3(cx + radius * std::cos(angle), 1.0f,
+                          cz + radius * std::sin(angle)));
+  }
+  return points;
+}
+
+// `count` square pens on a grid over the herd
+static void add_pens(GameState& GameState, int count, float extent) {
+  int perRow = static_cast<int>(std::ceil(std::sqrt(count)));
+  float spacing = 2.0f * extent / perRow;
+  for (int i = 0; i < count; i++) {
+    float cx = -extent + spacing * (i % perRow + 0.5f);
+    float cz = -extent + spacing * (i / perRow + 0.5f);
+    GameState.pens.push_back(std::make_unique<Pen>(
+        regular_polygon(cx, cz, spacing * 0.4f, 4), *GameState.ropes));
+  }
+}
+
+static void bench_collisions(Bench& bench) {
+  const BenchOptions& options = bench.options;
+  for (int animals = 1000; animals <= options.maxAnimals; animals *= 4) {
+    GameState GameState(1280, 720, options.threads, options.seed);
+    spawn_herd(GameState, animals);
+    const std::vector<vec3> start = GameState.animals->pos;
+    SimInput input;
+    auto reset = [&] { GameState.animals->pos = start; };
+
+    if (bench.enabled("handle_collisions")) {
+      // Fixed substeps so every size does the same amount of work
+      bench.run("handle_collisions", "animals", animals, animals, reset, [&] {
+        handle_collisions(GameState, input, MAX_SUBSTEPS);
+      });
+    }
+    if (bench.enabled("check_grid_collisions")) {
+      // One serial narrowphase pass over every occupied cell
+      bench.run(
+          "check_grid_collisions", "animals", animals, animals,
+          [&] {
+            reset();
+            build_animal_grid(GameState);
+          },
+          [&] {
+            CollisionStats stats;
+            for (const SpatialGrid::Cell& cell : GameState.animalGrid.cells()) {
+              check_grid_collisions(GameState.animalGrid, cell,
+                                    *GameState.animals, stats);
+            }
+          });
+    }
+  }
+}
+
+static void bench_pens(Bench& bench) {
+  const BenchOptions& options = bench.options;
+  const int animals = 16000;
+  for (int pens = 1; pens <= options.maxPens; pens *= 10) {
+    GameState GameState(1280, 720, options.threads, options.seed);
+    spawn_herd(GameState, animals);
+    add_pens(GameState, pens, spawn_extent(animals));
+
+    if (bench.enabled("pen_tracker_update")) {
+      // Steady state: animals wander a tick, then membership catches up
+      PenTracker& tracker = *GameState.penTracker;
+      tracker.update(GameState.pens, *GameState.animals);
+      uint64_t tick = 0;
+      bench.run(
+          "pen_tracker_update", "pens", pens, animals,
+          [&] {
+            GameState.animals->update(PHYSICS_TIME, options.seed, tick++);
+          },
+          [&] { tracker.update(GameState.pens, *GameState.animals); });
+    }
+    if (bench.enabled("pen_update")) {
+      // Every pen pays out, so the coin path runs too
+      for (auto& pen : GameState.pens) {
+        pen->species = Species(SpeciesType::SHEEP);
+        if (pen->contained_animals.empty()) {
+          pen->contained_animals.push_back(GameState.animals->handle_of(0));
+        }
+      }
+      bench.run("pen_update", "pens", pens, pens, [] {}, [&] {
+        for (uint32_t p = 0; p < GameState.pens.size(); p++) {
+          GameState.pens[p]->update(GameState, p, PHYSICS_TIME);
+        }
+        GameState.tick++;
+      });
+    }
+    if (bench.enabled("tube_batch")) {
+      // The rope mesh a frame builds, short of the upload
+      const RopeSystem& ropes = *GameState.ropes;
+      std::vector<vec3> points;
+      for (size_t i = 0; i < ropes.particle_count(); i++) {
+        points.push_back(vec3(ropes.xs()[i], ropes.ys()[i], ropes.zs()[i]));
+      }
+      TubeBatch tubes;
+      bench.run("tube_batch", "pens", pens, points.size(), [] {}, [&] {
+        tubes.clear();
+        for (const auto& pen : GameState.pens) {
+          for (RopeId edge : pen->edges) {
+            tubes.add(&points[ropes.particle_index(edge, 0)],
+                      ropes.count(edge), pen->thickness, pen->sides,
+                      pen->species.color);
+          }
+        }
+      });
+    }
+  }
+}
+
+static void bench_polygons(Bench& bench) {
+  const BenchOptions& options = bench.options;
+  const int queries = 4096;
+  for (int sides = 4; sides <= 256; sides *= 4) {
+    RopeSystem ropes;
+    Pen pen(regular_polygon(0.0f, 0.0f, 10.0f, sides), ropes);
+    RandomStream random(options.seed, RandomDomain::SPAWN);
+    std::vector<vec3> points;
+    for (int i = 0; i < queries; i++) {
+      points.push_back(vec3(random.uniform(-12.0f, 12.0f), 1.0f,
+                            random.uniform(-12.0f, 12.0f)));
+    }
+
+    if (bench.enabled("is_point_in_polygon")) {
+      bench.run("is_point_in_polygon", "sides", sides, queries, [] {}, [&] {
+        for (const vec3& point : points) {
+          do_not_optimize(is_point_in_polygon(point, pen));
+        }
+      });
+    }
+    if (bench.enabled("triangulate_polygon")) {
+      bench.run("triangulate_polygon", "sides", sides, 1, [] {}, [&] {
+        std::vector<std::array<vec2, 3>> triangles =
+            triangulatePolygon(pen.fixed_points);
+        do_not_optimize(triangles);
+      });
+    }
+    if (bench.enabled("select_random_triangle")) {
+      std::vector<std::array<vec2, 3>> triangles =
+          triangulatePolygon(pen.fixed_points);
+      bench.run("select_random_triangle", "sides", sides, 1, [] {}, [&] {
+        do_not_optimize(selectRandomTriangle(triangles, random));
+      });
+    }
+  }
+}
+
+static void bench_ropes(Bench& bench) {
+  const BenchOptions& options = bench.options;
+  // 64k particles in total, in ropes of each length
+  const int particles = 1 << 16;
+  for (int length = 4; length <= 1024; length *= 4) {
+    if (!bench.enabled("rope_solve")) {
+      break;
+    }
+    RopeSystem ropes;
+    RandomStream random(options.seed, RandomDomain::SPAWN);
+    std::vector<vec3> points(length);
+    for (int r = 0; r < particles / length; r++) {
+      vec3 start(random.uniform(-50.0f, 50.0f), 1.0f,
+                 random.uniform(-50.0f, 50.0f));
+      for (int i = 0; i < length; i++) {
+        points[i] = start + vec3(0.5f * i, 0.0f, random.uniform(-0.2f, 0.2f));
+      }
+      ropes.add_rope(points.data(), length, length, 0.4f, 0.99f);
+    }
+    bench.run("rope_solve", "length", length, particles, [] {},
+              [&] { ropes.solve(); });
+  }
+
+  if (bench.enabled("player_rope_update")) {
+    // The player's rope as the game drives it: ends pinned, then solved
+    GameState GameState(1280, 720, options.threads, options.seed);
+    Rope& rope = GameState.player->rope;
+    SimInput input;
+    input.mouseLeft = true;
+    for (int i = 0; i < 100; i++) {
+      rope.update(input, vec3(0.1f * i, 1.0f, 0.0f), vec3(0.0f, 1.0f, 5.0f),
+                  PHYSICS_TIME);
+    }
+    int frame = 0;
+    bench.run("player_rope_update", "points", rope.num_points, rope.num_points,
+              [] {}, [&] {
+                vec3 player(std::sin(0.01f * frame), 1.0f, 0.0f);
+                rope.update(input, player, vec3(0.0f, 1.0f, 5.0f),
+                            PHYSICS_TIME);
+                GameState.ropes->solve();
+                frame++;
+              });
+  }
+}
+
+// The game's default view of the field
+static Frustum default_view() {
+  const Matrix view = MatrixLookAt(CAMERA_OFFSET, vec3(0.0f, 0.0f, 0.0f),
+                                   vec3(0.0f, 1.0f, 0.0f));
+  const Matrix projection =
+      MatrixPerspective(60.0f * DEG2RAD, 16.0f / 9.0f, 0.01f, 1000.0f);
+  return Frustum::from_matrix(MatrixMultiply(view, projection));
+}
+
+static void bench_culling(Bench& bench) {
+  const BenchOptions& options = bench.options;
+  const Frustum frustum = default_view();
+  for (int animals = 1000; animals <= options.maxAnimals; animals *= 4) {
+    GameState GameState(1280, 720, options.threads, options.seed);
+    spawn_herd(GameState, animals);
+    SphereArray bounds;
+    for (uint32_t i = 0; i < GameState.animals->size(); i++) {
+      bounds.add(GameState.animals->pos[i], GameState.animals->radius(i));
+    }
+    std::vector<uint32_t> visible;
+
+    if (bench.enabled("sphere_cull")) {
+      bench.run("sphere_cull", "animals", animals, animals, [] {},
+                [&] { frustum.cull_spheres(bounds, visible); });
+    }
+  }
+}
+
+static void bench_terrain(Bench& bench) {
+  const Frustum frustum = default_view();
+  const BoundingBox bladeBounds = {vec3(-0.1f, 0.0f, -0.1f),
+                                   vec3(0.1f, 1.0f, 0.1f)};
+
+  if (bench.enabled("blade_transforms")) {
+    for (int blades = 15000; blades <= 240000; blades *= 4) {
+      std::vector<Matrix> transforms(blades);
+      bench.run("blade_transforms", "blades", blades, blades, [] {}, [&] {
+        RandomStream random(bench.options.seed, RandomDomain::GRASS);
+        generate_blade_transforms(transforms.data(), blades,
+                                  vec3(0.0f, 0.0f, 0.0f), 40.0f, random);
+      });
+    }
+  }
+
+  // Chunks built inline, so the timings include the building
+  const int side = 2 * TerrainStreamer::LOAD_RADIUS + 1;
+  const int activeChunks = side * side;
+  if (bench.enabled("grass_cull")) {
+    TerrainStreamer streamer(bench.options.seed, bladeBounds, 64 << 20, false);
+    streamer.update(vec3(0.0f, 0.0f, 0.0f));
+    std::vector<Matrix> visible;
+    bench.run("grass_cull", "chunks", activeChunks,
+              activeChunks * TerrainStreamer::BLADES_PER_CHUNK,
+              [&] { visible.clear(); },
+              [&] { streamer.cull(frustum, CAMERA_OFFSET, 1.0f, visible); });
+  }
+  if (bench.enabled("terrain_stream")) {
+    // Walk one chunk per call: a new row of chunks in, old rows evicted
+    TerrainStreamer streamer(bench.options.seed, bladeBounds,
+                             activeChunks * TerrainStreamer::BLADES_PER_CHUNK *
+                                 sizeof(Matrix),
+                             false);
+    float x = 0.0f;
+    bench.run("terrain_stream", "chunks", activeChunks, side, [] {}, [&] {
+      streamer.update(vec3(x, 0.0f, 0.0f));
+      x += TerrainStreamer::CHUNK_SIZE;
+    });
+    if (streamer.resident_chunks() != static_cast<size_t>(activeChunks)) {
+      printf("terrain_stream: %zu chunks resident, expected %d\n",
+             streamer.resident_chunks(), activeChunks);
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  BenchOptions options;
+  if (!parse_options(argc, argv, options)) {
+    print_usage(argv[0]);
+    return 1;
+  }
+  SetTraceLogLevel(LOG_WARNING);
+
+  Bench bench(options);
+  printf("%-24s %19s %10s %14s %14s\n", "benchmark", "param", "iters",
+         "ns/op", "items/s");
+  bench_collisions(bench);
+  bench_pens(bench);
+  bench_polygons(bench);
+  bench_ropes(bench);
+  bench_terrain(bench);
+  bench_culling(bench);
+
+  if (options.json) {
+    int threads = JobSystem(options.threads).thread_count();
+    if (!bench.write_json(options.json, threads)) {
+      fprintf(stderr, "cannot write %s\n", options.json);
+      return 1;
+    }
+  }
+  return 0;
+}
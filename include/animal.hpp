@@ -1,11 +1,12 @@
 #pragma once
 
-#include <random>
+#include <cstdint>
 
 #include "raylib-cpp.hpp"
+#include "rng.hpp"
 #include "utils.hpp"
 
-enum class SpeciesType { NULL_SPECIES, WOLF, SHEEP, COW };
+enum class SpeciesType : uint8_t { NULL_SPECIES, WOLF, SHEEP, COW };
 
 class Species {
  public:
@@ -17,24 +18,67 @@ class Species {
   Species(SpeciesType type);
 };
 
-SpeciesType getRandomSpecies();
+// Shared, immutable description of each species
+const Species &species_info(SpeciesType type);
 
-class Animal {
+SpeciesType getRandomSpecies(RandomStream &random);
+
+// Reference to an animal that stays valid while other animals are removed.
+// A removed animal's slot is recycled with a new generation, so stale
+// handles are detected instead of silently pointing at another animal.
+struct AnimalHandle {
+  uint32_t slot;
+  uint32_t generation;
+
+  bool operator==(const AnimalHandle &other) const {
+    return slot == other.slot && generation == other.generation;
+  }
+
+  // Unique over the whole run, for keying random streams
+  uint64_t key() const {
+    return (static_cast<uint64_t>(generation) << 32) | slot;
+  }
+};
+
+// Every animal in the world, stored as parallel arrays indexed 0..size()-1
+// so hot loops stream exactly the fields they read. Dense indices change on
+// remove(); hold an AnimalHandle to refer to one animal across ticks.
+class AnimalPool {
  public:
-  vec3 pos;
-  vec3 targ;
-  float speed;
-  Shader shader;
-  Model model;
-  double lastUpdateTime;
-  Species species;
-
-  Animal(vec3 pos, float speed, Shader shader);
-
-  void setNewRandomTarget();
-  void update();
-  void draw();
+  std::vector<vec3> pos;
+  std::vector<vec3> targ;
+  std::vector<SpeciesType> species;
+  std::vector<float> retargetTimer;  // Seconds since the last new target
+
+  size_t size() const { return pos.size(); }
+  bool empty() const { return pos.empty(); }
+  void clear();
+  void reserve(size_t count);
+
+  AnimalHandle add(vec3 position, SpeciesType type);
+  // O(1): the last animal moves into the removed animal's index
+  void remove(AnimalHandle handle);
+
+  bool valid(AnimalHandle handle) const;
+  uint32_t index_of(AnimalHandle handle) const;
+  AnimalHandle handle_of(uint32_t index) const;
+
+  float radius(uint32_t index) const {
+    return species_info(species[index]).radius;
+  }
+
+  void setNewRandomTarget(uint32_t index, RandomStream &random);
+  // Wander draws are keyed by animal and tick, so the result does not
+  // depend on the order animals are visited in
+  void update(float dt, uint64_t seed, uint64_t tick);
+
+ private:
+  friend struct SnapshotIO;  // Saves and restores the slot tables
+  std::vector<uint32_t> slotOfIndex;     // Dense index -> slot
+  std::vector<uint32_t> indexOfSlot;     // Slot -> dense index
+  std::vector<uint32_t> slotGeneration;  // Bumped every time a slot dies
+  std::vector<uint32_t> freeSlots;
 };
 
-std::vector<std::unique_ptr<Animal>> CreateAnimals(
-    const rl::Shader &shadowShader, int count);
+void spawn_animals(AnimalPool &animals, RandomStream &random, int count,
+                   float extent = 25.0f);
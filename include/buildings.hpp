@@ -7,7 +7,7 @@
 #include "collectables.hpp"
 #include "player.hpp"
 #include "raylib-cpp.hpp"
-#include "render_utils.hpp"
+#include "rope_system.hpp"
 #include "utils.hpp"
 
 // Axis-Aligned Bounding Box (AABB) struct
@@ -18,26 +18,31 @@ struct AABB {
 
 class Pen {
  private:
+  friend struct SnapshotIO;
   float coinTimer = 0.0f;  // Timer to accumulate time for coin addition
-  const float coinInterval = 8.0f;  // 1 second interval for adding coins
+  const float coinInterval = 8.0f;  // Seconds per coin for a single animal
+  const int maxCoins = 8;           // Pen stops dropping coins at this many
+  const float coinLifetime = 30.0f;  // Uncollected coins vanish after this
  public:
   std::vector<vec3> fixed_points;
-  std::vector<Animal *> contained_animals;
-  std::vector<Coin> contained_coins;
+  std::vector<AnimalHandle> contained_animals;
   Species species = Species(SpeciesType::NULL_SPECIES);
   float rope_segment_length = 1.0f;  // Desired length between rope points
   float constraint = 0.4f;           // Maximum distance between rope points
   float friction = 0.99f;            // Friction coefficient
   float thickness = 0.1f;            // Thickness of the rope
   int sides = 8;                     //[<35;139;19M]
-  std::vector<std::vector<vec3>> rope_points;
-  std::vector<std::vector<vec3>> rope_velocities;
+  RopeSystem *ropes;  // Owns the edge particles; see GameState::ropes
+  std::vector<RopeId> edges;  // One rope per fixed_points edge
   void initializeRopePoints();
-  Pen(std::vector<vec3> points);
-  bool checkCoinCollisions(GameState &GameState, Coin &coin);
-  void spawnCoin();
-  void update(GameState &GameState, float dt);
-  void draw(GameState &GameState);
+  Pen(std::vector<vec3> points, RopeSystem &ropes);
+  // Take over edge ropes that already exist in `ropes` (snapshot loading)
+  Pen(std::vector<vec3> points, RopeSystem &ropes, std::vector<RopeId> edges);
+  void spawnCoin(CoinPool &coins, uint32_t index, RandomStream &random);
+  // `index` is this pen's position in GameState.pens
+  void update(GameState &GameState, uint32_t index, float dt);
+  // Recompute species from contained_animals (see PenTracker)
+  void updateSpecies(const AnimalPool &animals);
 };
 
 class Fence {
@@ -45,15 +50,13 @@ class Fence {
   std::vector<vec2> points;
   float joinDist;
   Fence();
-  void place(vec2 point, std::vector<std::unique_ptr<Pen>> &pens);
+  void place(vec2 point, std::vector<std::unique_ptr<Pen>> &pens,
+             RopeSystem &ropes);
   void undo();
-  void draw(GameState &GameState);
 };
 
-void handle_building(GameState &GameState, Camera3D camera);
+// Apply the fence tool clicks in `input`
+void handle_building(GameState &GameState, const SimInput &input);
 
 AABB compute_aabb(const Pen &pen);
 bool is_point_in_polygon(const vec3 &point, const Pen &pen);
-void detect_animals_in_pens(
-    std::vector<std::unique_ptr<Pen>> &pens,
-    const std::vector<std::unique_ptr<Animal>> &animals);
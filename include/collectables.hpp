@@ -1,14 +1,49 @@
 #pragma once
 
 #include <cmath>
-#include <cstdlib>  // For rand()
+#include <cstdint>
+#include <vector>
 
+#include "spatial_grid.hpp"
 #include "utils.hpp"
 
-class Coin {
+// Random point inside the polygon `bounds` (xz plane), at coin height
+vec3 random_coin_position(const std::vector<vec3> &bounds,
+                          RandomStream &random);
+
+// Every uncollected coin in the world, as parallel arrays. Removal swaps the
+// last coin into the hole, so indices are only stable within a tick.
+class CoinPool {
  public:
-  Coin(std::vector<vec3> bounds);
-  vec3 pos;
-  float radius = 0.2;
-  void draw();
+  std::vector<vec3> pos;
+  std::vector<uint32_t> pen;  // Index of the pen that dropped the coin
+  std::vector<float> ttl;     // Seconds left before the coin disappears
+  float radius = 0.2f;
+
+  size_t size() const { return pos.size(); }
+  void clear();
+
+  void add(vec3 position, uint32_t pen, float lifetime);
+  void remove(uint32_t index);
+
+  // Coins currently alive from pen `pen`
+  int count_for_pen(uint32_t pen) const;
+
+  // Age every coin by dt and drop the expired ones
+  void expire(float dt);
+
+  // Remove every coin within `reach` of the segment from-to (a sphere when
+  // from == to) and return how many were removed. The first call after the
+  // coins change re-buckets them.
+  int collect_in_capsule(vec3 from, vec3 to, float reach);
+
+ private:
+  SpatialGrid grid = SpatialGrid(5.0f);
+  bool gridDirty = true;
+  std::vector<uint32_t> penCount;  // Alive coins per pen
+  std::vector<uint32_t> hits;
 };
+
+// Pick up every coin touched this tick by the player or tether (swept from
+// their previous positions) or by the rope, adding to GameState.coins
+void collect_coins(GameState &GameState, vec3 playerFrom, vec3 tetherFrom);
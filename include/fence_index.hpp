@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "buildings.hpp"
+#include "spatial_grid.hpp"
+
+// Spatial index over every pen's rope segments and posts for the
+// animal-vs-fence pass. Each feature is entered into every grid cell its box
+// (grown by how far an animal contact can reach) overlaps, so an animal only
+// has to look in its own cell. Boxes carry some slack and are refit lazily:
+// the index is rebuilt only when the pen list changes or a rope point
+// wanders out of its box.
+class FenceIndex {
+ public:
+  struct Feature {
+    uint32_t pen;    // Index into GameState.pens
+    uint32_t edge;   // Index into Pen::edges; unused for posts
+    uint32_t point;  // First rope point of the segment, or the post index
+    bool post;
+  };
+
+  explicit FenceIndex(float cellSize);
+
+  // Rebuild if the pens changed or a rope point left its box
+  void refit(const std::vector<std::unique_ptr<Pen>> &pens);
+
+  // Entries near the cell holding (x, z), or nullptr when no fence is close.
+  // Entries keep pen, edge, point order.
+  const SpatialGrid::Cell *find(float x, float z) const;
+  const Feature &feature(const SpatialGrid::Cell &cell, uint32_t i) const {
+    return features[entryFeature[grid.items()[cell.start + i]]];
+  }
+
+  // Box around everything pen `pen` can touch, contact reach included
+  const AABB &pen_bounds(uint32_t pen) const { return penBounds[pen]; }
+
+  bool empty() const { return features.empty(); }
+
+ private:
+  SpatialGrid grid;
+  std::vector<Feature> features;
+  std::vector<AABB> featureBounds;       // Segment box plus slack
+  std::vector<raylib::Vector3> entryPos;  // One cell center per feature cell
+  std::vector<uint32_t> entryFeature;     // Feature of each entry
+  std::vector<AABB> penBounds;
+  std::vector<const Pen *> indexedPens;  // Pens the index was built from
+
+  void rebuild(const std::vector<std::unique_ptr<Pen>> &pens);
+  bool is_stale(const std::vector<std::unique_ptr<Pen>> &pens) const;
+  void add_feature(const Feature &feature, const AABB &bounds);
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "raylib-cpp.hpp"
+
+// Bounding spheres one component per array, the layout cull_spheres reads
+struct SphereArray {
+  std::vector<float> x, y, z, radius;
+
+  size_t size() const { return x.size(); }
+  void clear();
+  void add(const Vector3 &center, float r);
+};
+
+// The view * projection matrix BeginMode3D sets up for `camera` on a target
+// of `aspect`
+Matrix camera_matrix(const Camera3D &camera, float aspect);
+
+// The six planes bounding what a camera sees, for culling on the CPU before
+// anything is submitted. Works for perspective and orthographic cameras.
+class Frustum {
+ public:
+  // Planes of a combined view * projection matrix, multiplied the way raylib
+  // does (MatrixMultiply(view, projection))
+  static Frustum from_matrix(const Matrix &viewProj);
+  // Planes of whatever BeginMode3D last set up
+  static Frustum from_current_matrices();
+  // Planes BeginMode3D would set up for `camera` on a target of `aspect`
+  static Frustum from_camera(const Camera3D &camera, float aspect);
+
+  // Conservative: may accept a box just outside a corner of the frustum
+  bool intersects_box(const BoundingBox &box) const;
+  bool intersects_sphere(const Vector3 &center, float radius) const;
+  // Replace `visible` with the indices of the spheres touching the
+  // frustum, in ascending order. The test of intersects_sphere, four
+  // spheres at a time (see simd.hpp).
+  void cull_spheres(const SphereArray &spheres,
+                    std::vector<uint32_t> &visible) const;
+
+ private:
+  // a*x + b*y + c*z + d >= 0 inside, with (a, b, c) of unit length
+  Vector4 planes[6];
+};
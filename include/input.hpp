@@ -0,0 +1,28 @@
+#pragma once
+
+#include "utils.hpp"
+
+// Snapshot of the player's controls for one simulation tick. The simulation
+// only ever reads this, never the window, so it can run headless.
+struct SimInput {
+  bool forward = false;    // W
+  bool back = false;       // S
+  bool left = false;       // A
+  bool right = false;      // D
+  bool ropeSlack = false;  // Left shift: rope passes through animals
+  bool mouseLeft = false;  // Extends the tether and the rope
+  // Clicks with the fence tool. One-shot: the game hands each click to a
+  // single tick, even when the frame that saw it runs several or none.
+  bool placeFence = false;
+  bool undoFence = false;
+  int tool = 0;  // Selected item: 0 rope, 1 fence (GameState::itemActive)
+  // Mouse wheel, narrowing the camera's field of view. Only the camera
+  // reads it, so it is not logged for replays.
+  float zoom = 0.0f;
+  // Ray through the cursor; defaults to straight down at the origin
+  Ray mouseRay = {{0.0f, 10.0f, 0.0f}, {0.0f, -1.0f, 0.0f}};
+};
+
+// Read the keyboard and mouse state of the current frame, with `tool` as
+// the selected item
+SimInput poll_input(const Camera3D &camera, int tool);
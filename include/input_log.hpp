@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "input.hpp"
+
+// Binary log of the SimInput fed to every tick of a session, plus the state
+// checksum after each tick. With the seed in the header, that is all a
+// replay needs to rerun the session exactly and find the first tick where
+// it goes wrong.
+//
+// Layout (version 1, little endian):
+//   header    "WRIL", u32 version, u64 seed
+//   per tick  u8 buttons, u8 flags, [6 x f32 mouse ray], u32 checksum
+// The mouse ray is only written on ticks where it changed, so an idle
+// tick costs 6 bytes.
+class InputRecorder {
+ public:
+  // Throws std::runtime_error if the file cannot be created
+  InputRecorder(const std::string &path, uint64_t seed);
+
+  // Append one tick: the input it ran with and state_checksum() after it
+  void record(const SimInput &input, uint64_t checksum);
+
+  uint64_t ticks() const { return tickCount; }
+
+ private:
+  std::ofstream out;
+  Ray lastRay;
+  uint64_t tickCount = 0;
+};
+
+struct InputLog {
+  uint64_t seed = 0;
+  std::vector<SimInput> inputs;     // One per tick
+  std::vector<uint32_t> checksums;  // Low half of state_checksum()
+};
+
+// Read a whole log. A record cut short at the end (the game was killed
+// mid-write) is dropped. Throws std::runtime_error on a missing file, a
+// file that is not an input log, or an unknown version.
+InputLog load_input_log(const std::string &path);
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+
+#include "raylib-cpp.hpp"
+
+// Copies of one mesh collected over a frame, each with its own transform and
+// color, drawn with a single instanced call per pass. The GPU buffers are
+// kept between frames and only grow, and the instance data is uploaded once
+// per frame no matter how many passes draw it.
+class InstanceBatch {
+ public:
+  void clear();
+  void add(const Matrix &transform, Color color);
+  size_t size() const { return colors.size(); }
+
+  // One draw call. The material's shader must read the transform from
+  // locs[SHADER_LOC_MATRIX_MODEL] and the color from colorLoc.
+  void draw(const Mesh &mesh, const Material &material, int colorLoc);
+
+  void unload();
+
+ private:
+  std::vector<float16> transforms;  // Column-major, as the shader reads them
+  std::vector<Color> colors;
+  unsigned int transformVbo = 0;
+  unsigned int colorVbo = 0;
+  size_t capacity = 0;  // Instances the VBOs can hold
+  bool dirty = false;   // Instances added since the last upload
+
+  void upload();
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed pool of worker threads for data-parallel loops. The calling thread
+// takes part in every loop, so a pool of one thread runs everything inline.
+class JobSystem {
+ public:
+  using RangeFn = std::function<void(size_t begin, size_t end)>;
+
+  // threadCount counts the caller; 0 picks one per hardware thread
+  explicit JobSystem(int threadCount = 0);
+  ~JobSystem();
+
+  JobSystem(const JobSystem &) = delete;
+  JobSystem &operator=(const JobSystem &) = delete;
+
+  int thread_count() const { return static_cast<int>(workers.size()) + 1; }
+
+  // Split [0, count) into chunks of `grain` and run fn on each, returning
+  // once all chunks are done. Chunks run in any order on any thread, so fn
+  // must only write state owned by its own range.
+  void parallel_for(size_t count, size_t grain, const RangeFn &fn);
+
+ private:
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable done;
+
+  // Current loop, published under mutex before generation is bumped
+  const RangeFn *job = nullptr;
+  size_t jobCount = 0;
+  size_t jobGrain = 1;
+  size_t jobChunks = 0;
+  std::atomic<size_t> nextChunk{0};
+
+  uint64_t generation = 0;
+  int joined = 0;   // Workers that picked up the current generation
+  int running = 0;  // Workers still inside the current generation
+  bool stopping = false;
+
+  void worker_loop();
+  void run_chunks();
+};
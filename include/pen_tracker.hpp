@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "animal.hpp"
+#include "buildings.hpp"
+#include "spatial_grid.hpp"
+
+// An animal entering or leaving a pen during the last PenTracker::update
+struct PenEvent {
+  uint32_t pen;  // Index into GameState.pens
+  AnimalHandle animal;
+  bool entered;
+};
+
+// Keeps every Pen::contained_animals up to date without re-testing the whole
+// herd each tick. When pens are added, each pen's polygon is baked into a
+// slope table and the cells of a coarse grid are classified per pen as
+// inside or boundary (cells outside every pen are simply absent). An animal
+// is only re-tested when it changes cell or sits in a boundary cell, and
+// only against the pens covering that cell.
+class PenTracker {
+ public:
+  PenTracker();
+
+  void update(std::vector<std::unique_ptr<Pen>> &pens,
+              const AnimalPool &animals);
+
+  // Membership changes found by the last update, in animal order
+  const std::vector<PenEvent> &events() const { return penEvents; }
+
+  // Point-in-polygon tests run by the last update
+  uint64_t polygon_tests() const { return polygonTests; }
+
+ private:
+  // Non-horizontal polygon edge with its precomputed slope dx/dz
+  struct Edge {
+    float startX, startZ;
+    float endZ;
+    float slope;
+  };
+  struct Shape {
+    std::vector<Edge> edges;
+    AABB bounds;
+  };
+  // A pen touching a grid cell
+  struct CellPen {
+    uint32_t pen;
+    bool boundary;  // An edge crosses the cell, so test the polygon
+  };
+  // Where an animal slot was last seen and which pens held it
+  struct SlotState {
+    uint32_t generation = UINT32_MAX;
+    int cellX = 0;
+    int cellZ = 0;
+    bool needsTest = true;  // Cell holds a boundary, or first sighting
+    std::vector<uint32_t> pens;
+  };
+
+  SpatialGrid grid;
+  std::vector<Shape> shapes;
+  std::vector<const Pen *> trackedPens;
+  std::vector<raylib::Vector3> entryPos;  // One cell center per CellPen
+  std::vector<CellPen> entries;
+  std::vector<SlotState> slots;
+  std::vector<PenEvent> penEvents;
+  std::vector<uint32_t> scratchPens;
+  std::vector<bool> penChanged;
+  uint64_t polygonTests = 0;
+
+  bool pens_changed(const std::vector<std::unique_ptr<Pen>> &pens) const;
+  void rebuild(std::vector<std::unique_ptr<Pen>> &pens,
+               const AnimalPool &animals);
+  bool contains(const Shape &shape, float x, float z) const;
+  void update_slot(SlotState &state, AnimalHandle handle, const vec3 &pos,
+                   std::vector<std::unique_ptr<Pen>> &pens);
+};
@@ -2,30 +2,47 @@
 
 #include "animal.hpp"
 #include "buildings.hpp"
+#include "input.hpp"
 #include "player.hpp"
+#include "spatial_grid.hpp"
 #include "utils.hpp"
-#include <stdatomic.h>
-#include <tuple>
-#include <unordered_map>
-#include <utility> // For std::pair
 #include <vector>
 
-struct pair_hash {
-  std::size_t operator()(const std::pair<int, int> &p) const {
-    return std::hash<int>()(p.first) ^ std::hash<int>()(p.second);
-  }
-};
+constexpr int GRID_SIZE = 5;
 
-using GridKey = std::pair<int, int>;
-using Grid = std::unordered_map<GridKey, std::vector<Animal *>, pair_hash>;
+// Bounds for the adaptive collision substep count
+constexpr int MIN_SUBSTEPS = 1;
+constexpr int MAX_SUBSTEPS = 8;
+// Animal overlap left after the last substep that calls for one more
+// substep next tick, and the overlap below which one can be dropped
+constexpr float PENETRATION_HIGH = 0.05f;
+constexpr float PENETRATION_LOW = 0.01f;
 
-constexpr int GRID_SIZE = 5;
+// Run `substeps` collision passes and record them in GameState.collisionStats
+void handle_collisions(GameState &GameState, const SimInput &input,
+                       int substeps);
+
+// Substep count for the next tick: one more while animals are still left
+// overlapping, one fewer once they are settled, the minimum when nothing
+// touches at all
+int adapt_substeps(const CollisionStats &stats, int substeps);
 
-void handle_collisions(GameState &GameState, int &substeps,
-                       std::vector<std::unique_ptr<Pen>> &pens);
+// Rebuild GameState.animalGrid from the current animal positions
+void build_animal_grid(GameState &GameState);
+// Resolve every animal pair owned by `cell` (see physics.cpp)
+void check_grid_collisions(const SpatialGrid &grid,
+                           const SpatialGrid::Cell &cell, AnimalPool &animals,
+                           CollisionStats &stats);
+// Sort the occupied cells of GameState.animalGrid into GameState.cellColors
+void assign_cell_colors(GameState &GameState);
+void collide_player_with_animals(GameState &GameState, CollisionStats &stats);
+void collide_rope_with_animals(GameState &GameState);
+// Refits GameState.fenceIndex, then resolves animal contacts with pen fences
+void collide_pens_with_animals(GameState &GameState);
 
-GridKey get_grid_key(const vec3 &pos, float grid_size);
-void add_to_grid(Grid &grid, Animal *animal, float grid_size);
-void check_grid_collisions(const Grid &grid, const GridKey &key,
-                           const float animalRadius, const float playerRadius,
-                           GameState &GameState);
+// Closest point on the segment start-end for `count` points given as SoA
+// coordinates: writes the segment parameter t in [0, 1] and the squared
+// distance for each point. Vectorized with simd::float4.
+void closest_points_on_segment(vec3 start, vec3 end, const float *x,
+                               const float *y, const float *z, size_t count,
+                               float *t, float *dist2);
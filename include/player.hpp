@@ -1,26 +1,25 @@
 #pragma once
 
+#include "input.hpp"
 #include "raylib-cpp.hpp"
+#include "rope_system.hpp"
 #include "utils.hpp"
 
 class Tether {
  public:
   vec3 pos;
   vec3 targ;
-  Shader shader;
   float radius = 0.4;
-  Model model;
   float maxDistance = 4.0;
 
-  Tether(Shader shader);
+  Tether();
 
-  void update(const Camera3D &camera, GameState &GameState, vec3 playerPos);
-
-  void draw();
+  void update(const SimInput &input, GameState &GameState, vec3 playerPos);
 };
 
 class Rope {
  private:
+  friend struct SnapshotIO;
   float deltaTimer = 0.0f;  // Timer to accumulate time for coin addition
   const float deltaInterval = 0.02f;  //
  public:
@@ -32,22 +31,21 @@ class Rope {
   int min_points = 8;
   int max_points = 15;
   float constraint;
-  std::vector<vec3> points;
-  std::vector<vec3> velocities;
+  RopeSystem *system;  // Owns the particles; see GameState::ropes
+  RopeId id;
   float friction = 0.999f;  // Friction factor (close to 1.0 means low friction,
                             // close to 0 means high friction)
 
   int sides = 10;
 
   Rope(vec3 playerPos, vec3 tetherPos, float thickness, int num_points,
-       float constraint);
+       float constraint, RopeSystem &system);
 
-  void init_points();
+  vec3 point(int i) const { return system->point(id, i); }
   void add_point(vec3 playerPos);
   void remove_point();
-  void update(vec3 playerPos, vec3 tetherPos, float dt);
-
-  void draw();
+  void update(const SimInput &input, vec3 playerPos, vec3 tetherPos,
+              float dt);
 };
 
 class Player {
@@ -63,16 +61,13 @@ class Player {
   Tether tether;
   Rope rope;
   vec3 com;
-  Shader shader;
-  Model model;
+  Matrix transform;  // Model transform for the character mesh
   float weight = 0.1;
   // Rope rope = Rope(pos, tether);
 
   // Constructor
-  Player(vec3 startPos, float speed, Shader shader);
+  Player(vec3 startPos, float speed, RopeSystem &ropes);
 
   // Method to handle input and move the player
-  void update();
-
-  void draw();
+  void update(const SimInput &input);
 };
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Scoped wall-clock timers for the frame stages. PROFILE_SCOPE("name")
+// records one event when the enclosing block exits into a ring buffer
+// owned by the calling thread, so recording takes no lock and never
+// allocates. Names must be string literals: only the pointer is stored.
+//
+// The profiler is compiled in with -DWRANGLER_PROFILE=ON. Without it the
+// macros expand to nothing, so the instrumented code is unchanged.
+namespace Profiler {
+
+struct Event {
+  const char *name;
+  uint64_t start;     // Nanoseconds on the steady clock
+  uint32_t duration;  // Nanoseconds, saturating at ~4.3 s
+  uint32_t depth;     // Scopes open on this thread when this one began
+};
+
+// Events of one thread, oldest first
+struct ThreadEvents {
+  std::string name;
+  uint32_t id;
+  std::vector<Event> events;
+};
+
+// Events each thread keeps; older ones are overwritten. About 25 seconds
+// of the game loop at 165 frames a second.
+constexpr uint32_t RING_CAPACITY = 1 << 16;
+
+uint64_t now_ns();
+
+// Label the calling thread's track in the trace
+void set_thread_name(const char *name);
+
+// Times one block; use PROFILE_SCOPE rather than naming one of these
+class Scope {
+ public:
+  explicit Scope(const char *name);
+  ~Scope();
+
+  Scope(const Scope &) = delete;
+  Scope &operator=(const Scope &) = delete;
+
+ private:
+  const char *name;
+  uint64_t start;
+};
+
+// Copy out every thread's events that ended after `since`. Safe to call
+// while other threads record; events overwritten mid-copy are dropped.
+std::vector<ThreadEvents> collect(uint64_t since);
+
+// The calling thread's last complete top-level scope, preceded by the
+// scopes nested in it in the order they ended. Empty before the first one
+// ends.
+std::vector<Event> last_frame();
+
+// Write the last `seconds` of events as Chrome trace_event JSON, viewable
+// in chrome://tracing or Perfetto. Returns false if the file cannot be
+// written.
+bool write_chrome_trace(const std::string &path, double seconds);
+
+}  // namespace Profiler
+
+#if WRANGLER_PROFILE
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) \
+  Profiler::Scope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_THREAD(name) Profiler::set_thread_name(name)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_THREAD(name)
+#endif
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "utils.hpp"
+
+// Simulation state as it was before the latest tick. Frames are drawn
+// between it and the current state, so motion stays smooth whether a frame
+// ran zero, one or several ticks.
+struct TickHistory {
+  std::vector<vec3> animalPos;
+  std::vector<vec3> ropePoints;
+  vec3 tetherPos;
+  Matrix playerTransform;
+  Camera3D camera;
+};
+
+// Remember the current state; call right before each tick
+void save_tick(const GameState &GameState, TickHistory &history);
+
+// A rope drawn as one tube, through a run of RenderSnapshot::ropePoints
+struct RopeTube {
+  uint32_t first;
+  uint32_t count;
+  float radius;
+  int sides;
+  Color color;
+};
+
+// A pen's edges and posts, as runs of RenderSnapshot::penEdges and posts
+struct PenView {
+  uint32_t firstEdge;
+  uint32_t edgeCount;
+  uint32_t firstPost;
+  uint32_t postCount;
+};
+
+// What the renderer draws of one tick, copied out of GameState by the
+// simulation thread. Holds no pointers into GameState, so a frame can be
+// drawn from it while the next tick runs.
+struct RenderSnapshot {
+  uint64_t tick = 0;
+  double time = 0.0;     // When the tick was due (see SimThread::now)
+  TickHistory previous;  // The tick before, to blend from
+
+  std::vector<vec3> animalPos;
+  std::vector<float> animalRadius;
+  std::vector<Color> animalColor;
+  std::vector<vec3> ropePoints;  // Every rope particle, by particle index
+  RopeTube playerRope;
+  std::vector<RopeTube> penEdges;
+  std::vector<vec3> posts;
+  std::vector<PenView> pens;
+  vec3 tetherPos;
+  float tetherRadius;
+  Matrix playerTransform;
+  std::vector<vec3> coinPos;
+  float coinRadius;
+  std::vector<vec2> fencePoints;  // The fence being placed
+  float fenceJoinDist;
+  Camera3D camera;
+  int coins;
+};
+
+// Fill `snapshot` from the state after a tick and the history saved before
+// it. Reuses the snapshot's storage.
+void capture_render_snapshot(const GameState &GameState,
+                             const TickHistory &history,
+                             RenderSnapshot &snapshot);
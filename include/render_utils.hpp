@@ -6,10 +6,16 @@
 
 #include "animal.hpp"
 #include "buildings.hpp"
+#include "collectables.hpp"
+#include "frustum.hpp"
+#include "instancing.hpp"
 #include "player.hpp"
 #include "raylib-cpp.hpp"
+#include "render_snapshot.hpp"
 #include "rlgl.h"
+#include "shader_program.hpp"
 #include "terrain.hpp"
+#include "tube_batch.hpp"
 #include "utils.hpp"
 
 #if defined(PLATFORM_DESKTOP)
@@ -20,8 +26,106 @@
 
 #define SHADOWMAP_RESOLUTION 2048
 
+// Texture slot the lit shaders read the shadow map from
+const int SHADOW_MAP_SLOT = 10;
+
+// Share of grass blades drawn into the shadow map
+const float GRASS_SHADOW_DENSITY = 0.5f;
+// Shadow casters are drawn coarser: a 2048 map over 80 units has 4 cm
+// texels, which cannot show a 20-ring sphere or a 10-sided rope
+const int SHADOW_SPHERE_RINGS = 8;
+const int SHADOW_ROPE_SIDES = 4;
+
 namespace RenderUtils {
 
+// A lit shader (lighting or instanced) and the uniforms set every frame
+struct LitProgram {
+  ShaderProgram program;
+  ShaderProgram::Uniform viewPos;
+  ShaderProgram::Uniform lightDir;
+  ShaderProgram::Uniform lightVP;
+};
+
+// GPU resources the simulation state is drawn with. Owned by the window side
+// so GameState stays free of shaders and models.
+struct SceneAssets {
+  Model playerModel;
+  std::unique_ptr<Terrain> terrain;
+
+  LitProgram lit;  // The shadow shader: player, ground
+  // Lit like the shadow shader, but reads transform and color per instance
+  Shader instancedShader;
+  LitProgram instancedLit;
+  int instanceColorLoc;
+  Material instancedMaterial;
+  Mesh sphereMesh;  // Unit sphere: tether, animals and coins
+  Mesh postMesh;    // Unit cylinder standing on y = 0: pen posts
+  InstanceBatch spheres;
+  InstanceBatch posts;
+  // Shadow casters: the tether and the animals in the light's view. Coins
+  // are too small to matter.
+  Mesh shadowSphereMesh;
+  InstanceBatch shadowSpheres;
+  // The player's rope and the pens, and the fence being placed, which
+  // casts no shadow
+  TubeBatch ropeTubes;
+  TubeBatch fenceTubes;
+  // The same ropes with SHADOW_ROPE_SIDES sides, for the shadow pass
+  TubeBatch shadowRopeTubes;
+  // Rope particles and player pose for this frame, filled with the batches
+  std::vector<vec3> ropePoints;  // Indexed like RopeSystem's raw arrays
+  Matrix playerTransform;
+  // Scratch for culling in collect_instances
+  SphereArray bounds;
+  std::vector<uint32_t> visible;
+  std::vector<uint8_t> penSeen;
+};
+
+// Depth of field, chosen at runtime: OFF shows the scene as drawn, LOW
+// blurs at quarter resolution, HIGH at half
+enum class DofQuality { OFF, LOW, HIGH };
+
+// The depth-of-field chain. The scene is drawn into `scene` at full
+// resolution, blurred horizontally into `blurH` and vertically into `blurV`
+// at the quality's reduced resolution, then composited with the sharp
+// scene on the way to the screen.
+struct DofPass {
+  DofQuality quality = DofQuality::HIGH;
+  RenderTexture2D scene = {};
+  RenderTexture2D blurH = {};  // Left unloaded while OFF
+  RenderTexture2D blurV = {};
+  Shader blurShader = {};
+  ShaderProgram blur;
+  ShaderProgram::Uniform blurDirection;
+  ShaderProgram::Uniform blurResolution;
+  Shader compositeShader = {};
+  int blurredLoc = -1;  // Sampler for blurV in compositeShader
+};
+
+// The render thread's side of the game: the snapshot being drawn and what
+// only the window knows. GameState belongs to the simulation thread.
+struct FrameState {
+  const RenderSnapshot *snapshot = nullptr;
+  float alpha = 0.0f;  // How far from snapshot->previous to draw
+  Camera3D view;       // The snapshot's camera, blended by alpha
+  Camera3D lightCam;
+  vec2 mouse_proj;     // Cursor on the rope plane, through `view`
+  int itemActive = 0;  // Selected tool, sent to the sim with the input
+  int screenWidth;
+  int screenHeight;
+};
+
+// Camera alpha of the way from history to the current tick
+Camera3D blend_camera(const TickHistory &history, const Camera3D &camera,
+                      float alpha);
+
+SceneAssets LoadSceneAssets(Shader shadowShader, const vec3 &lightDir);
+
+// Stage this frame's camera and light in every shader and send what
+// changed. Call once a frame before the first pass.
+void update_uniforms(SceneAssets &assets, const Camera3D &view,
+                     const Camera3D &lightCam, const vec3 &lightDir);
+
 void InitializeWindow(int &screenWidth, int &screenHeight);
 
 Camera3D SetupCamera();
@@ -31,30 +135,68 @@ Camera3D SetupLightCamera();
 RenderTexture2D LoadShadowmapRenderTexture(int width, int height);
 void UnloadShadowmapRenderTexture(RenderTexture2D target);
 
-void update_camera(GameState &GameState);
+// Follow the player; the mouse widens the view while the rope is out and
+// the wheel zooms. Runs once a tick, on the simulation thread.
+void update_camera(GameState &GameState, const SimInput &input);
+
+void draw_player(const Matrix &transform, Model &model);
+// Add each rope as one tube through its particles
+void add_rope(const RopeTube &rope, const std::vector<vec3> &points,
+              TubeBatch &tubes);
+void add_pen(const RenderSnapshot &snapshot, const PenView &pen,
+             const std::vector<vec3> &points, TubeBatch &tubes);
+// The fence so far, out to the mouse, with its posts
+void add_fence(const RenderSnapshot &snapshot, vec2 mouse, TubeBatch &tubes);
+// The ring the mouse must be in to close the fence
+void draw_fence_join(const RenderSnapshot &snapshot);
+
+// Fill the instance and tube batches, rope points and player pose once per
+// frame, frame.alpha of the way from the snapshot's previous tick to its
+// own; both passes draw from them. Shadow casters are culled to
+// frame.lightCam.
+void collect_instances(FrameState &frame, SceneAssets &assets);
 
-bool is_in_camera_view(const Vector3 &position, float radius, const Camera &camera, int screenWidth,
-                       int screenHeight);
+// Draw everything inside BeginMode3D. Grass is culled to the current
+// camera's frustum and thinned by distance from `viewer`.
+void draw_scene(FrameState &frame, SceneAssets &assets,
+                const Camera3D &viewer);
+// The shadow pass's own list: sparser grass, coarse spheres, and
+// nothing too small to cast a visible shadow (coins, the fence preview)
+void draw_shadow_casters(SceneAssets &assets, const Camera3D &viewer);
 
-void draw_scene(GameState &GameState);
+void UnloadResources(Shader shadowShader, RenderTexture2D shadowMap, SceneAssets &assets,
+                     DofPass &dof);
 
-void UnloadResources(Shader shadowShader, RenderTexture2D shadowMap, GameState &GameState,
-                     Shader dofShader, RenderTexture2D dofTexture);
+// (Re)create the chain's render targets for the screen size and quality
+void SetupDofTexture(DofPass &dof, int screenWidth, int screenHeight);
 
-RenderTexture2D SetupDofTexture(int screenWidth, int screenHeight);
+DofPass SetupDofShader(int screenWidth, int screenHeight);
 
-rl::Shader SetupDofShader(int screenWidth, int screenHeight);
+// Switch quality, reallocating the reduced targets
+void SetDofQuality(DofPass &dof, DofQuality quality);
 
-rl::Shader SetupShadowShader(vec3 &lightDir);
+// Blur and composite dof.scene onto the screen; call inside BeginDrawing
+void RenderDof(DofPass &dof);
 
-void RenderShadowMap(Shader shadowShader, RenderTexture2D &shadowMap, Camera3D &lightCam,
-                     GameState &GameState);
+rl::Shader SetupShadowShader();
 
-void RenderSceneToTexture(RenderTexture2D &dofTexture, Camera3D &camera, rl::Shader &shadowShader,
-                          RenderTexture2D &shadowMap, GameState &GameState);
+Shader SetupInstancedShader();
 
-void HandleWindowResize(GameState &GameState, int &screenWidth, int &screenHeight,
-                        RenderTexture2D &dofTexture, Shader &dofShader);
+void RenderShadowMap(RenderTexture2D &shadowMap, Camera3D &lightCam,
+                     FrameState &frame, SceneAssets &assets);
 
-void DrawGUI(GameState &GameState, int &screenWidth, int &screenHeight);
+void RenderSceneToTexture(RenderTexture2D &dofTexture, Camera3D &camera,
+                          RenderTexture2D &shadowMap, FrameState &frame,
+                          SceneAssets &assets);
+
+void HandleWindowResize(FrameState &frame, int &screenWidth, int &screenHeight,
+                        DofPass &dof);
+
+void DrawGUI(FrameState &frame, int &screenWidth, int &screenHeight);
+
+#if WRANGLER_PROFILE
+// Flame bar of the last frame's scopes on the main thread, one row per
+// nesting depth. CPU time only: GPU work shows up in whichever call waits.
+void DrawProfilerBar(float x, float y);
+#endif
 } // namespace RenderUtils
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+// What a random number is for. Each purpose draws from its own streams, so
+// adding a draw to one never shifts the numbers another one sees.
+enum class RandomDomain : uint32_t { SPAWN, WANDER, COIN, GRASS };
+
+// Counter-based random numbers. A stream is named by (seed, domain, key,
+// subkey) and its n-th value is a hash of that name and n, with no state
+// shared between streams. An animal keyed by its handle and the tick gets
+// the same numbers on any thread in any order, and a whole run follows
+// from its seed. The hash is SplitMix64's finalizer.
+class RandomStream {
+ public:
+  RandomStream(uint64_t seed, RandomDomain domain, uint64_t key = 0,
+               uint64_t subkey = 0);
+
+  uint64_t next_u64();
+  // Uniform in [0, 1)
+  float next_float();
+  // Uniform in [min, max)
+  float uniform(float min, float max);
+  // Uniform in [min, max], both ends included like GetRandomValue
+  int uniform_int(int min, int max);
+
+  // Draws made so far; with the name, this is the whole stream state
+  uint64_t position() const { return counter; }
+  void seek(uint64_t position) { counter = position; }
+
+ private:
+  uint64_t base;
+  uint64_t counter = 0;
+};
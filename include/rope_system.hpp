@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "raylib-cpp.hpp"
+
+using RopeId = uint32_t;
+
+// Every rope particle in the game (the player's rope and each pen edge) in
+// one set of parallel arrays, with each rope owning a fixed run of slots.
+// solve() relaxes all of them in a single pass over the flat buffer, so the
+// cost per tick is one loop no matter how many pens exist.
+//
+// The relaxation is the one the ropes always used: each free particle moves
+// toward the midpoint of where its neighbors would put it if every segment
+// were clamped to the rope's max segment length, scaled by the rope's
+// friction. First and last particles of a rope are pinned.
+class RopeSystem {
+ public:
+  int iterations = 2;  // Jacobi sweeps per solve()
+  // Most sweeps a loaded snapshot may ask for
+  static constexpr int MAX_ITERATIONS = 16;
+
+  // Add a rope of `count` particles, with room to grow to `capacity`
+  RopeId add_rope(const raylib::Vector3 *points, uint32_t count,
+                  uint32_t capacity, float maxSegmentLength, float friction);
+
+  // Shrink or grow a rope within its capacity; new particles start at
+  // `fill`. The new last particle becomes the pinned end.
+  void set_count(RopeId rope, uint32_t count, raylib::Vector3 fill);
+
+  uint32_t count(RopeId rope) const { return ropes[rope].count; }
+  raylib::Vector3 point(RopeId rope, uint32_t i) const {
+    uint32_t p = ropes[rope].offset + i;
+    return {x[p], y[p], z[p]};
+  }
+  // Where particle i of `rope` sits in the raw arrays below
+  uint32_t particle_index(RopeId rope, uint32_t i) const {
+    return ropes[rope].offset + i;
+  }
+  void set_point(RopeId rope, uint32_t i, raylib::Vector3 pos);
+  void displace(RopeId rope, uint32_t i, raylib::Vector3 delta);
+
+  void solve();
+
+  // Raw particle arrays, for hashing and bulk readers
+  size_t particle_count() const { return x.size(); }
+  const float *xs() const { return x.data(); }
+  const float *ys() const { return y.data(); }
+  const float *zs() const { return z.data(); }
+
+ private:
+  friend struct SnapshotIO;  // Saves and restores the flat arrays
+  struct Range {
+    uint32_t offset;
+    uint32_t count;
+    uint32_t capacity;
+    float friction;
+  };
+
+  std::vector<Range> ropes;
+  std::vector<float> x, y, z;
+  std::vector<float> maxLength;  // Segment length limit per particle
+  std::vector<float> step;       // Friction for free particles, 0 if pinned
+  std::vector<float> nextX, nextY, nextZ;
+
+  void relax(size_t begin, size_t end);
+};
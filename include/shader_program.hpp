@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "raylib-cpp.hpp"
+
+// A shader's uniforms, looked up by name once when it is loaded. Values are
+// staged on the CPU with set() and sent by flush(), once a frame before
+// drawing; a uniform whose value has not changed since it was last sent is
+// skipped. Does not own the shader.
+class ShaderProgram {
+ public:
+  using Uniform = int;  // Handle from uniform()
+
+  ShaderProgram() = default;
+  explicit ShaderProgram(Shader shader);
+
+  // Look up `name`; asking again for the same name returns the same handle
+  Uniform uniform(const char *name);
+
+  void set(Uniform uniform, int value);
+  void set(Uniform uniform, float value);
+  void set(Uniform uniform, Vector2 value);
+  void set(Uniform uniform, Vector3 value);
+  void set(Uniform uniform, Vector4 value);
+  void set(Uniform uniform, const Matrix &value);
+
+  void flush();
+
+  Shader shader() const { return program; }
+  // Over every program: uniforms sent, and sets that were not (overwritten
+  // before a flush, or equal to what the GPU already has)
+  static uint64_t total_sent() { return sent; }
+  static uint64_t total_skipped() { return skipped; }
+
+ private:
+  static constexpr int MATRIX = -1;  // In place of a SHADER_UNIFORM_* type
+
+  struct Slot {
+    std::string name;
+    int location;
+    int type = 0;
+    size_t size = 0;
+    unsigned char staged[sizeof(Matrix)];
+    unsigned char uploaded[sizeof(Matrix)];
+    bool pending = false;   // Staged since the last flush
+    bool everSent = false;  // `uploaded` holds what the GPU has
+  };
+
+  Shader program = {};
+  std::vector<Slot> slots;
+
+  static uint64_t sent;
+  static uint64_t skipped;
+
+  void stage(Uniform uniform, const void *value, size_t size, int type);
+};
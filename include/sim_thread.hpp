@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "input.hpp"
+#include "render_snapshot.hpp"
+#include "tick_clock.hpp"
+#include "triple_buffer.hpp"
+
+class Autosave;
+class InputRecorder;
+
+// Runs the simulation on its own thread, a tick every PHYSICS_TIME, so a
+// slow tick does not hold up a frame and a slow frame does not hold up the
+// simulation. Input goes in through send(), stamped with the time it was
+// polled; each tick comes out as a RenderSnapshot through a triple buffer,
+// which the render thread reads without locking. The web build has no
+// threads, so there update() runs the due ticks on the caller's thread.
+class SimThread {
+ public:
+  // Starts ticking at once. GameState, recorder and autosave must outlive
+  // this, and nothing else may touch GameState until it is destroyed.
+  SimThread(GameState &GameState, InputRecorder *recorder,
+            Autosave &autosave, bool background = true);
+  ~SimThread();
+
+  SimThread(const SimThread &) = delete;
+  SimThread &operator=(const SimThread &) = delete;
+
+  // Seconds since construction, on the clock input and snapshots use
+  double now() const;
+
+  // Queue input polled just now. Ticks due from now on use it: held keys
+  // until the next send, clicks and wheel turns in one tick only.
+  void send(const SimInput &input);
+
+  // Without a background thread, run the ticks that are due
+  void update();
+
+  // The newest snapshot. It stays unchanged until the next call.
+  const RenderSnapshot &latest();
+
+  // How far now() is past `snapshot`'s tick, in ticks, from 0 to 1
+  float alpha(const RenderSnapshot &snapshot) const;
+
+ private:
+  struct TimedInput {
+    double time;
+    SimInput input;
+  };
+
+  GameState &game;
+  InputRecorder *recorder;
+  Autosave &autosave;
+  bool background;
+  const std::chrono::steady_clock::time_point start;
+
+  // Sim thread only
+  TickClock clock;
+  double lastAdvance = 0.0;
+  SimInput held;  // Merged input for the next tick
+  TickHistory history;
+
+  std::mutex inputMutex;
+  std::vector<TimedInput> queued;  // Oldest first
+
+  TripleBuffer<RenderSnapshot> snapshots;
+  std::atomic<bool> stopping{false};
+  std::thread worker;
+
+  void worker_loop();
+  void run_due_ticks();
+  SimInput take_input(double due);
+  void run_tick(const SimInput &input, double due);
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+// Minimal 4-wide float vector for the hot batched kernels. Uses SSE where
+// the compiler targets it and plain arrays elsewhere (e.g. the web build),
+// so kernels are written once against float4.
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WRANGLER_SIMD_SSE 1
+#include <emmintrin.h>
+#else
+#define WRANGLER_SIMD_SSE 0
+#include <cmath>
+#endif
+
+namespace simd {
+
+#if WRANGLER_SIMD_SSE
+
+struct float4 {
+  __m128 v;
+};
+
+inline float4 load(const float *p) { return {_mm_loadu_ps(p)}; }
+inline void store(float *p, float4 a) { _mm_storeu_ps(p, a.v); }
+inline float4 splat(float s) { return {_mm_set1_ps(s)}; }
+inline float4 operator+(float4 a, float4 b) { return {_mm_add_ps(a.v, b.v)}; }
+inline float4 operator-(float4 a, float4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline float4 operator*(float4 a, float4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+inline float4 min(float4 a, float4 b) { return {_mm_min_ps(a.v, b.v)}; }
+inline float4 max(float4 a, float4 b) { return {_mm_max_ps(a.v, b.v)}; }
+inline float4 operator/(float4 a, float4 b) { return {_mm_div_ps(a.v, b.v)}; }
+inline float4 sqrt(float4 a) { return {_mm_sqrt_ps(a.v)}; }
+// Lanes where a > b take ifTrue, the rest ifFalse
+inline float4 select_gt(float4 a, float4 b, float4 ifTrue, float4 ifFalse) {
+  __m128 mask = _mm_cmpgt_ps(a.v, b.v);
+  return {_mm_or_ps(_mm_and_ps(mask, ifTrue.v),
+                    _mm_andnot_ps(mask, ifFalse.v))};
+}
+// Bit i set when lane i of a <= b
+inline int mask_le(float4 a, float4 b) {
+  return _mm_movemask_ps(_mm_cmple_ps(a.v, b.v));
+}
+
+#else
+
+struct float4 {
+  float v[4];
+};
+
+inline float4 load(const float *p) { return {{p[0], p[1], p[2], p[3]}}; }
+inline void store(float *p, float4 a) {
+  for (int i = 0; i < 4; i++) p[i] = a.v[i];
+}
+inline float4 splat(float s) { return {{s, s, s, s}}; }
+
+#define WRANGLER_SIMD_LANEWISE(name, expr) \
+  inline float4 name(float4 a, float4 b) { \
+    float4 r;                              \
+    for (int i = 0; i < 4; i++)            \
+      r.v[i] = expr;                       \
+    return r;                              \
+  }
+WRANGLER_SIMD_LANEWISE(operator+, a.v[i] + b.v[i])
+WRANGLER_SIMD_LANEWISE(operator-, a.v[i] - b.v[i])
+WRANGLER_SIMD_LANEWISE(operator*, a.v[i] * b.v[i])
+WRANGLER_SIMD_LANEWISE(min, a.v[i] < b.v[i] ? a.v[i] : b.v[i])
+WRANGLER_SIMD_LANEWISE(max, a.v[i] > b.v[i] ? a.v[i] : b.v[i])
+WRANGLER_SIMD_LANEWISE(operator/, a.v[i] / b.v[i])
+#undef WRANGLER_SIMD_LANEWISE
+
+inline float4 sqrt(float4 a) {
+  for (int i = 0; i < 4; i++)
+    a.v[i] = std::sqrt(a.v[i]);
+  return a;
+}
+inline float4 select_gt(float4 a, float4 b, float4 ifTrue, float4 ifFalse) {
+  for (int i = 0; i < 4; i++)
+    ifFalse.v[i] = a.v[i] > b.v[i] ? ifTrue.v[i] : ifFalse.v[i];
+  return ifFalse;
+}
+
+inline int mask_le(float4 a, float4 b) {
+  int mask = 0;
+  for (int i = 0; i < 4; i++) mask |= (a.v[i] <= b.v[i]) << i;
+  return mask;
+}
+
+#endif
+
+}  // namespace simd
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "input.hpp"
+#include "utils.hpp"
+
+// Length of one simulation tick in seconds
+const float PHYSICS_TIME = 1.0 / 60.0;
+
+// Advance the game logic by one tick of PHYSICS_TIME. Touches no window,
+// shader or model, so it is shared by the game and the headless driver.
+// Collision substeps adapt from tick to tick through GameState.substeps.
+void step_simulation(GameState &GameState, const SimInput &input);
+
+// Hash of the simulated state (animals, player, ropes, coins), for checking
+// that two runs took exactly the same path
+uint64_t state_checksum(const GameState &GameState);
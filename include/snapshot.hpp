@@ -0,0 +1,76 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "utils.hpp"
+
+// Versioned binary image of the simulated world: animals, ropes, pens,
+// coins, the player and every timer and random stream position. Each kind
+// of data is one flat array, so loading is a bulk copy per array with no
+// per-object parsing. Derived state (grids, pen membership, the fence
+// index) is rebuilt on load instead of stored.
+//
+// File layout (little endian): a 32-byte file header, then the image,
+// stored as is or DEFLATE-compressed. The image is a fixed header with a
+// section table, followed by the arrays at 16-byte aligned offsets, so an
+// uncompressed file can be mapped and read in place.
+constexpr uint32_t SNAPSHOT_VERSION = 1;
+
+// Copy the world into a new image. Only bulk copies, cheap enough to take
+// at any tick boundary.
+std::vector<uint8_t> capture_snapshot(const GameState &GameState);
+
+// Replace the world in GameState with an image. The job pool, cameras and
+// screen size are left alone. Throws std::runtime_error if the image is
+// truncated, from another version, or refers to data it does not hold.
+void restore_snapshot(GameState &GameState, const uint8_t *image,
+                      size_t size);
+
+// Write an image to `path`, DEFLATE-compressed when `compress` is set. The
+// file is written next to `path` and renamed over it, so a crash never
+// leaves a half-written save behind. Throws std::runtime_error on failure.
+void write_snapshot_file(const std::string &path,
+                         const std::vector<uint8_t> &image, bool compress);
+
+// Load a file written by write_snapshot_file into GameState. Uncompressed
+// files are memory-mapped where the platform allows.
+void load_snapshot_file(GameState &GameState, const std::string &path);
+
+// Saves the world every `intervalTicks` ticks without stalling the game:
+// the image is captured on the calling thread at a tick boundary, and
+// compressed and written on a worker thread of its own.
+class Autosave {
+ public:
+  Autosave(std::string path, uint64_t intervalTicks);
+  // Waits for a save in progress to finish
+  ~Autosave();
+
+  Autosave(const Autosave &) = delete;
+  Autosave &operator=(const Autosave &) = delete;
+
+  // Call after every tick. When a save is due but the last one is still
+  // being written, this one is skipped rather than queued.
+  void update(const GameState &GameState);
+
+  uint64_t saves_written() const;
+
+ private:
+  std::string path;
+  uint64_t intervalTicks;
+  uint64_t lastSaveTick = 0;
+
+  mutable std::mutex mutex;
+  std::condition_variable wake;
+  std::vector<uint8_t> pending;  // Image waiting for the worker
+  bool busy = false;             // Set from hand-off until written
+  bool stopping = false;
+  uint64_t written = 0;
+  std::thread worker;
+
+  void worker_loop();
+};
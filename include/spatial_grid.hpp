@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "raylib-cpp.hpp"
+
+// Uniform grid over the xz plane, stored flat. Items are counting-sorted into
+// hashed buckets so each occupied cell is one contiguous run of item indices.
+// All arrays keep their capacity, so rebuilding every substep allocates
+// nothing once the population has stopped growing.
+class SpatialGrid {
+ public:
+  // Contiguous run of item indices that share one cell
+  struct Cell {
+    int x;
+    int z;
+    uint32_t start;  // Offset into items()
+    uint32_t count;
+  };
+
+  explicit SpatialGrid(float cellSize);
+
+  // Re-bucket `count` positions; item i is positions[i]
+  void build(const raylib::Vector3 *positions, size_t count);
+
+  // Cell coordinates of a world position
+  int cell_coord(float v) const;
+
+  // Occupied cell at (x, z), or nullptr when nothing is there
+  const Cell *find_cell(int x, int z) const;
+
+  // Every occupied cell, in a stable order that only depends on the input
+  const std::vector<Cell> &cells() const { return occupied; }
+
+  // Item indices sorted by cell; index with Cell::start
+  const uint32_t *items() const { return sorted.data(); }
+
+  float cell_size() const { return cellSize; }
+
+ private:
+  float cellSize;
+  float invCellSize;
+  uint32_t bucketMask;
+  std::vector<uint32_t> bucketStart;  // First slot of each bucket in sorted
+  std::vector<uint32_t> bucketCount;  // Items per bucket
+  std::vector<uint32_t> bucketCell;   // First entry of each bucket in occupied
+  std::vector<uint32_t> sorted;       // Item indices grouped by bucket, cell
+  std::vector<uint64_t> itemKey;      // Packed cell coordinates per item
+  std::vector<Cell> occupied;
+
+  static uint64_t pack_key(int x, int z);
+  uint32_t bucket_of(uint64_t key) const;
+};
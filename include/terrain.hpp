@@ -1,7 +1,12 @@
 #pragma once
 
+#include <memory>
+#include <vector>
+
+#include "frustum.hpp"
 #include "raylib-cpp.hpp"
-#include "render_utils.hpp"
+#include "shader_program.hpp"
+#include "terrain_streamer.hpp"
 #include "utils.hpp"
 
 class Blade {
@@ -14,11 +19,23 @@ class Blade {
 class Terrain {
  public:
   Terrain(Shader shadowShader);
-  void draw();
-  void update(GameState& GameState, float dt);  // New update method
+  // Draw the ground and the grass visible through `frustum`, at `density`
+  // (see TerrainStreamer::cull)
+  void draw(const Frustum& frustum, vec3 eye, float density);
+  // Wind, and streaming grass in around `focus`, what the camera looks at.
+  // The wind is staged in `grass`; the caller flushes it.
+  void update(vec3 focus, float dt);
   Blade blade;
-  int bladeCount;
   Model planeModel;
-  Matrix* transforms;
-  float windTime;  // New wind time accumulator
+  ShaderProgram grass;  // The blades' instanced shader
+  ShaderProgram::Uniform windParams;
+  std::unique_ptr<TerrainStreamer> streamer;
+  std::vector<Matrix> visible;  // Blades submitted by the last draw
+  float windTime;               // New wind time accumulator
 };
+
+// Scale, tilt and scatter `count` grass blades over the square of
+// half-side `halfSize` around `center`. Pure math, so it runs without a
+// window (see wrangler_bench).
+void generate_blade_transforms(Matrix* transforms, int count, vec3 center,
+                               float halfSize, RandomStream& random);
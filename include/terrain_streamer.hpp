@@ -0,0 +1,119 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "frustum.hpp"
+#include "raylib-cpp.hpp"
+#include "utils.hpp"
+
+struct ChunkCoord {
+  int32_t x;
+  int32_t z;
+};
+
+// One square of grass. Blades keep their random order, so any prefix of
+// `blades` is an even thinning of the chunk.
+struct GrassChunk {
+  ChunkCoord coord;
+  BoundingBox bounds;  // Every blade, padded for wind sway
+  std::vector<Matrix> blades;
+};
+
+// Build the chunk at `coord` from `seed` and the coordinate alone, so a
+// chunk comes back the same however often it is evicted and rebuilt.
+// `bladeBounds` is the blade mesh's own box.
+GrassChunk generate_grass_chunk(uint64_t seed,
+                                ChunkCoord coord,
+                                const BoundingBox &bladeBounds);
+
+// Keeps the grass chunks around a moving point resident. Missing chunks are
+// built nearest first on a worker thread of its own (inline on the web),
+// and chunks left behind are evicted least recently used first once the
+// cache is over its memory budget. Chunks in the active square around the
+// point are never evicted, so the budget must hold at least those.
+class TerrainStreamer {
+ public:
+  static constexpr float CHUNK_SIZE = 8.0f;
+  static constexpr int BLADES_PER_CHUNK = 600;
+  // Chunks kept around the center in each direction; the view reaches ~35
+  static constexpr int LOAD_RADIUS = 6;
+
+  TerrainStreamer(uint64_t seed,
+                  const BoundingBox &bladeBounds,
+                  size_t budgetBytes,
+                  bool background = true);
+  // Waits for a chunk being built to finish
+  ~TerrainStreamer();
+
+  TerrainStreamer(const TerrainStreamer &) = delete;
+  TerrainStreamer &operator=(const TerrainStreamer &) = delete;
+
+  // Call once a frame. Takes in chunks the worker has finished, queues the
+  // missing ones around `center` and evicts down to the budget. Without a
+  // background worker the missing chunks are built before returning.
+  void update(vec3 center);
+
+  // Append the blades of every resident chunk touching `frustum` to `out`,
+  // thinned with distance from `eye` (see LOD_NEAR)
+  void cull(const Frustum &frustum,
+            vec3 eye,
+            float density,
+            std::vector<Matrix> &out) const;
+
+  // Center of the active square, snapped to the chunk grid
+  vec3 active_center() const;
+  size_t resident_chunks() const { return cache.size(); }
+  size_t resident_bytes() const { return residentBytes; }
+  uint64_t chunks_built() const { return built; }
+  uint64_t chunks_evicted() const { return evicted; }
+
+  // A chunk keeps `density` of its blades out to LOD_NEAR from the eye,
+  // thinning to LOD_FAR_DENSITY of that at LOD_FAR and beyond
+  static constexpr float LOD_NEAR = 15.0f;
+  static constexpr float LOD_FAR = 45.0f;
+  static constexpr float LOD_FAR_DENSITY = 0.3f;
+
+ private:
+  struct Entry {
+    GrassChunk chunk;
+    std::list<uint64_t>::iterator recent;  // Position in `lru`
+  };
+
+  uint64_t seed;
+  BoundingBox bladeBounds;
+  size_t budgetBytes;
+  bool background;
+
+  // Main thread only
+  std::unordered_map<uint64_t, Entry> cache;
+  std::list<uint64_t> lru;  // Most recently active first
+  size_t residentBytes = 0;
+  ChunkCoord center = {0, 0};
+  bool started = false;
+  uint64_t built = 0;
+  uint64_t evicted = 0;
+
+  // Shared with the worker, under mutex
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::deque<ChunkCoord> queue;     // Nearest first
+  std::vector<GrassChunk> finished;  // Built, waiting for update()
+  bool building = false;            // The worker holds `inFlight`
+  uint64_t inFlight = 0;
+  bool stopping = false;
+  std::thread worker;
+
+  bool is_active(ChunkCoord coord) const;
+  std::vector<ChunkCoord> missing_chunks() const;
+  void adopt(GrassChunk chunk);
+  void touch_active();
+  void evict();
+  void worker_loop();
+};
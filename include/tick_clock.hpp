@@ -0,0 +1,27 @@
+#pragma once
+
+// Turns variable frame times into whole simulation ticks of a fixed length.
+// Leftover time is carried to the next frame and exposed as alpha(), the
+// fraction of a tick the renderer should blend past the last tick.
+class TickClock {
+ public:
+  // maxTicksPerFrame bounds the catch-up after a slow frame; the rest of
+  // the backlog is dropped so the sim slows down instead of spiraling
+  explicit TickClock(float tickLength, int maxTicksPerFrame = 4);
+
+  // Bank frameTime and return how many ticks to run this frame
+  int advance(float frameTime);
+
+  // How far the banked time reaches into the next tick, in [0, 1)
+  float alpha() const { return accumulator / tickLength; }
+
+  float tick_length() const { return tickLength; }
+  // Ticks thrown away by the catch-up limit since construction
+  long long dropped_ticks() const { return droppedTicks; }
+
+ private:
+  float tickLength;
+  int maxTicksPerFrame;
+  float accumulator = 0.0f;
+  long long droppedTicks = 0;
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <atomic>
+
+// Hands whole values from one writer thread to one reader thread without
+// locks. The writer fills back() and publishes it; the reader takes the
+// newest published value with acquire() and reads front() until it next
+// acquires. Neither side ever waits: a value the reader did not get to in
+// time is overwritten by the next one. Buffers are reused, so a T that
+// holds vectors stops allocating once they reach their working size.
+template <typename T>
+class TripleBuffer {
+ public:
+  // Writer side
+  T &back() { return buffers[backIndex]; }
+  void publish() {
+    backIndex = middle.exchange(backIndex | FRESH, std::memory_order_acq_rel) &
+                INDEX;
+  }
+
+  // Reader side. Returns whether front() changed.
+  bool acquire() {
+    if ((middle.load(std::memory_order_relaxed) & FRESH) == 0) {
+      return false;
+    }
+    frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & INDEX;
+    return true;
+  }
+  const T &front() const { return buffers[frontIndex]; }
+
+ private:
+  // `middle` holds the index of the buffer between the two sides, with
+  // FRESH set while the reader has not yet taken it
+  static constexpr int INDEX = 3;
+  static constexpr int FRESH = 4;
+
+  T buffers[3];
+  int backIndex = 0;   // Writer's
+  std::atomic<int> middle{1};
+  int frontIndex = 2;  // Reader's
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+
+#include "raylib-cpp.hpp"
+#include "utils.hpp"
+
+// Polylines drawn as capped tubes, built into one mesh per frame. Segments
+// of a polyline share the ring of vertices where they meet. The GPU buffers
+// are kept between frames and only grow, and the mesh is uploaded once per
+// frame no matter how many passes draw it. Drawn unlit in their vertex
+// colors with raylib's default shader, like DrawCylinderEx.
+class TubeBatch {
+ public:
+  void clear();
+  // A tube of `sides` sides through `count` points
+  void add(const vec3 *points, size_t count, float radius, int sides,
+           Color color);
+  void add_segment(vec3 start, vec3 end, float radius, int sides,
+                   Color color);
+  size_t vertex_count() const;
+
+  // One draw call per page, with whatever matrices BeginMode3D set up
+  void draw();
+
+  void unload();
+
+ private:
+  // Indices are 16-bit, so a page holds at most this many vertices and a
+  // frame spills onto more pages as needed
+  static constexpr size_t PAGE_VERTICES = 65536;
+
+  struct Page {
+    std::vector<Vector3> positions;
+    std::vector<Color> colors;
+    std::vector<unsigned short> indices;
+    unsigned int vao = 0;
+    unsigned int positionVbo = 0;
+    unsigned int colorVbo = 0;
+    unsigned int indexEbo = 0;
+    size_t vertexCapacity = 0;  // What the buffers can hold
+    size_t indexCapacity = 0;
+    bool dirty = false;  // Tubes added since the last upload
+  };
+
+  std::vector<Page> pages;
+  size_t used = 0;  // Pages holding this frame's tubes
+  // Scratch for add(): the path without repeats, and the ring's offsets
+  // along the normal and binormal
+  std::vector<vec3> path;
+  std::vector<float> ringX;
+  std::vector<float> ringY;
+
+  Page &page_for(size_t vertices);
+  void add_tube(const vec3 *points, size_t count, int sides, Color color);
+  static void upload(Page &page);
+  static void unload(Page &page);
+};
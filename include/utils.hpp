@@ -5,7 +5,10 @@
 #include <memory>
 #include <vector>
 
+#include "jobs.hpp"
 #include "raylib-cpp.hpp"
+#include "rng.hpp"
+#include "spatial_grid.hpp"
 
 namespace rl = raylib;     // Create an alias for the raylib namespace
 using vec3 = rl::Vector3;  // Define vec3 as an alias for raylib's Vector3
@@ -16,38 +19,65 @@ const vec3 CAMERA_OFFSET = {0.0, 15.0, 8.0};
 
 class Pen;
 class Fence;
-class Animal;
+class AnimalPool;
+class CoinPool;
+class RopeSystem;
+class FenceIndex;
+class PenTracker;
 class Player;
-class Terrain;
+
+// Narrowphase work done by one handle_collisions call, over all substeps
+struct CollisionStats {
+  uint64_t pairsTested = 0;       // Sphere-sphere tests, player included
+  uint64_t contactsResolved = 0;  // Tests that found an overlap
+  float maxPenetration = 0.0f;    // Deepest animal overlap, last substep
+};
 
 class GameState {
  public:
   int screenWidth;
   int screenHeight;
+  uint64_t seed;      // Every random draw in the sim derives from this
+  uint64_t tick = 0;  // Ticks simulated so far
+  RandomStream spawnRandom;  // Herd spawns, drawn in order on the main thread
   bool toggleFence;
   int itemActive;
   float addAnimalInterval = 2.0;
   float addAnimalTimer = 0.0;
-  int coins;
+  int coins;  // Collected so far
   Camera3D camera;
-  Camera3D lightCam;
-  std::unique_ptr<Terrain> terrain;
+  // Player rope and pen edges; declared before player, whose rope
+  // registers itself on construction
+  std::unique_ptr<RopeSystem> ropes;
   std::unique_ptr<Player> player;
-  std::vector<std::unique_ptr<Animal>> animals;
+  std::unique_ptr<AnimalPool> animals;
   std::unique_ptr<Fence>
       fence;  // Use unique_ptr for automatic memory management
   std::vector<std::unique_ptr<Pen>> pens;  // Use unique_ptr here as well
-  vec2 mouse_proj;
-
-  GameState(const rl::Shader &shadowShader, const int screenWidth,
-            const int screenHeight);
-  void addAnimal(const rl::Shader &shadowShader);
+  std::unique_ptr<FenceIndex> fenceIndex;  // Pen segments and posts by cell
+  std::unique_ptr<PenTracker> penTracker;  // Keeps pen membership current
+  std::unique_ptr<CoinPool> coinPool;      // Coins waiting to be picked up
+  SpatialGrid animalGrid;  // Rebuilt in place every collision substep
+  // Occupied grid cells split into 3x3 color classes; cells of one color
+  // are never neighbors, so each class can be solved in parallel
+  std::array<std::vector<uint32_t>, 9> cellColors;
+  std::unique_ptr<JobSystem> jobs;
+  CollisionStats collisionStats;  // From the last handle_collisions call
+  int substeps = 8;  // Collision substeps for the next tick (adapt_substeps)
+
+  // Simulation state only; cameras and GPU resources are set up by the
+  // window side (see RenderUtils::LoadSceneAssets). threadCount sizes the
+  // collision job pool; 0 uses every hardware thread. Runs with the same
+  // seed and input play out identically.
+  GameState(const int screenWidth, const int screenHeight,
+            int threadCount = 0, uint64_t seed = 1);
+  ~GameState();
+  void addAnimal();
 };
 
 // Function declarations
 float lerp_to(float position, float target, float rate);
 vec3 lerp3D(vec3 position, vec3 target, float rate);
-float GetRandomFloat(float min, float max);
 // Helper function to get the closest point on a line segment to a point
 vec3 GetClosestPointOnLineFromPoint(vec3 point, vec3 lineStart, vec3 lineEnd);
 
@@ -70,11 +100,12 @@ std::vector<std::array<vec2, 3>> triangulatePolygon(
     const std::vector<vec3> &bounds);
 
 std::array<vec2, 3> selectRandomTriangle(
-    const std::vector<std::array<vec2, 3>> &triangles);
+    const std::vector<std::array<vec2, 3>> &triangles, RandomStream &random);
 
 float calculateTriangleArea(const vec2 &p1, const vec2 &p2, const vec2 &p3);
 
-vec2 generateRandomPointInTriangle(const std::array<vec2, 3> &tri);
+vec2 generateRandomPointInTriangle(const std::array<vec2, 3> &tri,
+                                   RandomStream &random);
 
 float normalizeAngle(float angle);
 
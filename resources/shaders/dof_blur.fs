@@ -0,0 +1,39 @@
+#version 330
+
+// One direction of the depth-of-field blur, drawn at reduced resolution.
+// Offsets are in full-resolution pixels, so every quality blurs as wide.
+
+uniform sampler2D texture0;  // The previous step of the chain
+uniform vec2 resolution;     // Screen resolution
+uniform vec2 direction;      // (1, 0) or (0, 1)
+uniform float radius;        // Maximum blur radius at top/bottom
+
+in vec2 fragTexCoord;
+out vec4 finalColor;
+
+// Below this the outermost tap lands within half a pixel: nothing to blur
+const float MIN_RADIUS = 0.125;
+
+void main() {
+    // Gaussian weights for 9 taps, the center first
+    float kernel[5] = float[](0.227027, 0.1945946, 0.1216216, 0.054054, 0.016216);
+
+    // 0 across the middle of the screen, rising to radius at top/bottom
+    float verticalDistance = abs((fragTexCoord.y - 0.5) * 1.5);
+    float dynamicRadius = mix(0.0, radius, verticalDistance);
+
+    vec3 color = texture(texture0, fragTexCoord).rgb;
+    if (dynamicRadius < MIN_RADIUS) {
+        finalColor = vec4(color, 1.0);
+        return;
+    }
+
+    vec2 offset = direction / resolution * dynamicRadius;
+    color *= kernel[0];
+    for (int i = 1; i <= 4; i++) {
+        color += texture(texture0, fragTexCoord + offset * float(i)).rgb * kernel[i];
+        color += texture(texture0, fragTexCoord - offset * float(i)).rgb * kernel[i];
+    }
+
+    finalColor = vec4(color, 1.0);
+}
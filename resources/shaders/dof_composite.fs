@@ -0,0 +1,30 @@
+#version 330
+
+// Full-resolution end of the depth-of-field chain: the sharp scene in the
+// middle of the screen, fading into the blurred copy toward top/bottom.
+
+uniform sampler2D texture0;  // The sharp scene
+uniform sampler2D blurred;   // Both blur directions, at reduced resolution
+uniform float radius;        // Maximum blur radius at top/bottom
+
+in vec2 fragTexCoord;
+out vec4 finalColor;
+
+// Must match dof_blur.fs
+const float MIN_RADIUS = 0.125;
+
+void main() {
+    float verticalDistance = abs((fragTexCoord.y - 0.5) * 1.5);
+    float dynamicRadius = mix(0.0, radius, verticalDistance);
+
+    // Blur under a pixel wide fades in gradually
+    float amount = clamp((dynamicRadius - MIN_RADIUS) / (1.0 - MIN_RADIUS),
+                         0.0, 1.0);
+    vec3 sharp = texture(texture0, fragTexCoord).rgb;
+    if (amount <= 0.0) {
+        finalColor = vec4(sharp, 1.0);
+        return;
+    }
+
+    finalColor = vec4(mix(sharp, texture(blurred, fragTexCoord).rgb, amount), 1.0);
+}
@@ -0,0 +1,34 @@
+#version 330
+
+// Input vertex attributes
+in vec3 vertexPosition;
+in vec2 vertexTexCoord;
+in vec3 vertexNormal;
+
+// Per-instance attributes
+in mat4 instanceTransform;
+in vec4 instanceColor;
+
+// Input uniform values (mvp is view * projection, the model matrix comes
+// from the instance)
+uniform mat4 mvp;
+
+// Output vertex attributes (to fragment shader)
+out vec3 fragPosition;
+out vec2 fragTexCoord;
+out vec4 fragColor;
+out vec3 fragNormal;
+
+void main()
+{
+    vec4 worldPosition = instanceTransform*vec4(vertexPosition, 1.0);
+
+    // Send vertex attributes to fragment shader
+    fragPosition = worldPosition.xyz;
+    fragTexCoord = vertexTexCoord;
+    fragColor = instanceColor;
+    fragNormal = normalize(mat3(instanceTransform)*vertexNormal);
+
+    // Calculate final vertex position
+    gl_Position = mvp*worldPosition;
+}
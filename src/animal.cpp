@@ -25,12 +25,8 @@ Species::Species(SpeciesType type) : type(type) {
   }
 }
 
-SpeciesType getRandomSpecies() {
-  static std::random_device rd;
-  static std::mt19937 gen(rd());
-  static std::uniform_int_distribution<> dis(0, 2);
-
-  int randomNumber = dis(gen);
+SpeciesType getRandomSpecies(RandomStream& random) {
+  int randomNumber = random.uniform_int(0, 2);
   switch (randomNumber) {
     case 0:
       return SpeciesType::WOLF;
@@ -43,50 +39,129 @@ SpeciesType getRandomSpecies() {
   }
 }
 
-Animal::Animal(vec3 pos, float speed, Shader shader)
-    : pos(pos),
-      speed(speed),
-      shader(shader),
-      lastUpdateTime(0),
-      species(getRandomSpecies()) {
-  targ = pos;
-  model = LoadModelFromMesh(GenMeshSphere(species.radius, 20, 20));
-  model.materials[0].shader = shader;
+const Species &species_info(SpeciesType type) {
+  static const Species table[] = {
+      Species(SpeciesType::NULL_SPECIES), Species(SpeciesType::WOLF),
+      Species(SpeciesType::SHEEP), Species(SpeciesType::COW)};
+  return table[static_cast<int>(type)];
+}
+
+void AnimalPool::clear() {
+  pos.clear();
+  targ.clear();
+  species.clear();
+  retargetTimer.clear();
+  slotOfIndex.clear();
+  indexOfSlot.clear();
+  slotGeneration.clear();
+  freeSlots.clear();
+}
+
+void AnimalPool::reserve(size_t count) {
+  pos.reserve(count);
+  targ.reserve(count);
+  species.reserve(count);
+  retargetTimer.reserve(count);
+  slotOfIndex.reserve(count);
+}
+
+AnimalHandle AnimalPool::add(vec3 position, SpeciesType type) {
+  uint32_t index = static_cast<uint32_t>(pos.size());
+  uint32_t slot;
+  if (!freeSlots.empty()) {
+    slot = freeSlots.back();
+    freeSlots.pop_back();
+  } else {
+    slot = static_cast<uint32_t>(indexOfSlot.size());
+    indexOfSlot.push_back(0);
+    slotGeneration.push_back(0);
+  }
+  indexOfSlot[slot] = index;
+  slotOfIndex.push_back(slot);
+
+  pos.push_back(position);
+  targ.push_back(position);
+  species.push_back(type);
+  retargetTimer.push_back(0.0f);
+  return AnimalHandle{slot, slotGeneration[slot]};
+}
+
+void AnimalPool::remove(AnimalHandle handle) {
+  if (!valid(handle)) {
+    return;
+  }
+  uint32_t index = indexOfSlot[handle.slot];
+  uint32_t last = static_cast<uint32_t>(pos.size() - 1);
+
+  // Move the last animal into the hole and repoint its slot
+  pos[index] = pos[last];
+  targ[index] = targ[last];
+  species[index] = species[last];
+  retargetTimer[index] = retargetTimer[last];
+  slotOfIndex[index] = slotOfIndex[last];
+  indexOfSlot[slotOfIndex[index]] = index;
+
+  pos.pop_back();
+  targ.pop_back();
+  species.pop_back();
+  retargetTimer.pop_back();
+  slotOfIndex.pop_back();
+
+  slotGeneration[handle.slot]++;
+  freeSlots.push_back(handle.slot);
+}
+
+bool AnimalPool::valid(AnimalHandle handle) const {
+  return handle.slot < slotGeneration.size() &&
+         slotGeneration[handle.slot] == handle.generation;
+}
+
+uint32_t AnimalPool::index_of(AnimalHandle handle) const {
+  return indexOfSlot[handle.slot];
+}
+
+AnimalHandle AnimalPool::handle_of(uint32_t index) const {
+  uint32_t slot = slotOfIndex[index];
+  return AnimalHandle{slot, slotGeneration[slot]};
 }
 
-void Animal::setNewRandomTarget() {
+void AnimalPool::setNewRandomTarget(uint32_t index, RandomStream& random) {
   // Define the range for random movement (e.g., [-1.0, 1.0])
   float rangep = 1.0f;
 
   // Generate a random value within the range for both x and z coordinates
-  float rangeX = ((float)GetRandomValue(-1000, 1000) / 1000.0f) * rangep;
-  float rangeZ = ((float)GetRandomValue(-1000, 1000) / 1000.0f) * rangep;
+  float rangeX = ((float)random.uniform_int(-1000, 1000) / 1000.0f) * rangep;
+  float rangeZ = ((float)random.uniform_int(-1000, 1000) / 1000.0f) * rangep;
 
   // Update the target position with the new random values
-  targ.x = targ.x + rangeX;
-  targ.z = targ.z + rangeZ;
+  targ[index].x = targ[index].x + rangeX;
+  targ[index].z = targ[index].z + rangeZ;
 }
 
-void Animal::update() {
-  double currentTime = GetTime();
-  if (currentTime - lastUpdateTime >= 1.0) {
-    setNewRandomTarget();
-    lastUpdateTime = currentTime;
+void AnimalPool::update(float dt, uint64_t seed, uint64_t tick) {
+  const uint32_t count = static_cast<uint32_t>(size());
+  for (uint32_t i = 0; i < count; i++) {
+    retargetTimer[i] += dt;
+    if (retargetTimer[i] >= 1.0f) {
+      RandomStream random(seed, RandomDomain::WANDER, handle_of(i).key(), tick);
+      setNewRandomTarget(i, random);
+      retargetTimer[i] = 0.0f;
+    }
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    pos[i] = lerp3D(pos[i], targ[i], 0.03);
   }
-
-  pos = lerp3D(pos, targ, 0.03);
-  model.transform = MatrixTranslate(pos.x, pos.y, pos.z);
 }
 
-void Animal::draw() { DrawModel(model, Vector3Zero(), 1.0f, species.color); }
-
-std::vector<std::unique_ptr<Animal>> CreateAnimals(
-    const rl::Shader &shadowShader, int count) {
-  std::vector<std::unique_ptr<Animal>> animals;
+void spawn_animals(AnimalPool &animals,
+                   RandomStream &random,
+                   int count,
+                   float extent) {
+  animals.reserve(animals.size() + count);
   for (int i = 0; i < count; i++) {
-    animals.push_back(std::make_unique<Animal>(
-        vec3{GetRandomFloat(-25, 25), 1.0f, GetRandomFloat(-25, 25)}, 5.0f,
-        shadowShader));
+    // Evaluate in a fixed order so a seeded run spawns the same herd
+    float x = random.uniform(-extent, extent);
+    float z = random.uniform(-extent, extent);
+    animals.add(vec3{x, 1.0f, z}, getRandomSpecies(random));
   }
-  return animals;
 }
@@ -1,17 +1,123 @@
 #include "collectables.hpp"
 
-Coin::Coin(std::vector<vec3> bounds) {
+#include <algorithm>
+#include <functional>
+
+#include "player.hpp"
+
+vec3 random_coin_position(const std::vector<vec3>& bounds,
+                          RandomStream& random) {
   // Triangulate the polygon in the xz plane
   std::vector<std::array<vec2, 3>> triangles = triangulatePolygon(bounds);
 
   // Randomly select a triangle based on its area
-  std::array<vec2, 3> selectedTriangle = selectRandomTriangle(triangles);
+  std::array<vec2, 3> selectedTriangle =
+      selectRandomTriangle(triangles, random);
 
   // Generate a random point within the selected triangle
-  vec2 randomPoint2D = generateRandomPointInTriangle(selectedTriangle);
+  vec2 randomPoint2D =
+      generateRandomPointInTriangle(selectedTriangle, random);
 
   // Extend to vec3, keeping y = 0 (xz plane)
-  pos = vec3{randomPoint2D.x, 1.0f, randomPoint2D.y};
+  return vec3{randomPoint2D.x, 1.0f, randomPoint2D.y};
+}
+
+void CoinPool::clear() {
+  pos.clear();
+  pen.clear();
+  ttl.clear();
+  penCount.clear();
+  gridDirty = true;
+}
+
+void CoinPool::add(vec3 position, uint32_t penIndex, float lifetime) {
+  pos.push_back(position);
+  pen.push_back(penIndex);
+  ttl.push_back(lifetime);
+  if (penIndex >= penCount.size()) {
+    penCount.resize(penIndex + 1, 0);
+  }
+  penCount[penIndex]++;
+  gridDirty = true;
+}
+
+void CoinPool::remove(uint32_t index) {
+  penCount[pen[index]]--;
+  pos[index] = pos.back();
+  pen[index] = pen.back();
+  ttl[index] = ttl.back();
+  pos.pop_back();
+  pen.pop_back();
+  ttl.pop_back();
+  gridDirty = true;
+}
+
+int CoinPool::count_for_pen(uint32_t penIndex) const {
+  return penIndex < penCount.size() ? penCount[penIndex] : 0;
+}
+
+void CoinPool::expire(float dt) {
+  for (uint32_t i = 0; i < ttl.size();) {
+    ttl[i] -= dt;
+    if (ttl[i] <= 0.0f) {
+      remove(i);  // The swapped-in coin is aged on this same index next
+    } else {
+      i++;
+    }
+  }
 }
 
-void Coin::draw() { DrawSphere(pos, radius, YELLOW); }
+int CoinPool::collect_in_capsule(vec3 from, vec3 to, float reach) {
+  if (pos.empty()) {
+    return 0;
+  }
+  if (gridDirty) {
+    grid.build(pos.data(), pos.size());
+    gridDirty = false;
+  }
+
+  hits.clear();
+  const int minX = grid.cell_coord(std::min(from.x, to.x) - reach);
+  const int maxX = grid.cell_coord(std::max(from.x, to.x) + reach);
+  const int minZ = grid.cell_coord(std::min(from.z, to.z) - reach);
+  const int maxZ = grid.cell_coord(std::max(from.z, to.z) + reach);
+  for (int x = minX; x <= maxX; x++) {
+    for (int z = minZ; z <= maxZ; z++) {
+      const SpatialGrid::Cell* cell = grid.find_cell(x, z);
+      if (!cell) {
+        continue;
+      }
+      for (uint32_t c = 0; c < cell->count; c++) {
+        uint32_t coin = grid.items()[cell->start + c];
+        if (CheckCollisionPointLine(pos[coin], from, to, reach)) {
+          hits.push_back(coin);
+        }
+      }
+    }
+  }
+
+  // Highest index first so swap-remove never moves a coin still to remove
+  std::sort(hits.begin(), hits.end(), std::greater<uint32_t>());
+  for (uint32_t coin : hits) {
+    remove(coin);
+  }
+  return static_cast<int>(hits.size());
+}
+
+void collect_coins(GameState& GameState, vec3 playerFrom, vec3 tetherFrom) {
+  const float playerRadius = 1.5f;
+  const float tetherRadius = 0.5f;
+  CoinPool& coins = *GameState.coinPool;
+  const Player& player = *GameState.player;
+  const Rope& rope = player.rope;
+
+  int collected = coins.collect_in_capsule(playerFrom, player.pos,
+                                           playerRadius + coins.radius);
+  collected += coins.collect_in_capsule(tetherFrom, player.tether.pos,
+                                        tetherRadius + coins.radius);
+  for (int i = 0; i < rope.num_points - 1 && coins.size() > 0; ++i) {
+    collected += coins.collect_in_capsule(rope.point(i), rope.point(i + 1),
+                                          coins.radius + rope.thickness);
+  }
+  GameState.coins += collected;
+}
@@ -0,0 +1,131 @@
+#include "fence_index.hpp"
+
+#include <algorithm>
+
+// How far a rope point may drift before the index is rebuilt
+static const float FENCE_SLACK = 1.0f;
+// Posts push animals out to this distance from their center
+static const float POST_RADIUS = 1.0f;
+
+// Largest animal radius of any species
+static float max_animal_radius() {
+  float radius = 0.0f;
+  for (SpeciesType type : {SpeciesType::NULL_SPECIES, SpeciesType::WOLF,
+                           SpeciesType::SHEEP, SpeciesType::COW}) {
+    radius = std::max(radius, species_info(type).radius);
+  }
+  return radius;
+}
+
+// Distance from a feature at which an animal can still touch it: the post
+// radius, plus the animal's radius twice since a post push earlier in the
+// same pass can move the animal that far before the segments are tested
+static float contact_reach() {
+  return POST_RADIUS + 2.0f * max_animal_radius() + 0.05f;
+}
+
+static AABB segment_bounds(vec3 start, vec3 end, float margin) {
+  return {{std::min(start.x, end.x) - margin, 0.0f,
+           std::min(start.z, end.z) - margin},
+          {std::max(start.x, end.x) + margin, 0.0f,
+           std::max(start.z, end.z) + margin}};
+}
+
+static bool contains_xz(const AABB& box, const vec3& point) {
+  return point.x >= box.min.x && point.x <= box.max.x &&
+         point.z >= box.min.z && point.z <= box.max.z;
+}
+
+FenceIndex::FenceIndex(float cellSize) : grid(cellSize) {}
+
+void FenceIndex::add_feature(const Feature& feature, const AABB& bounds) {
+  const uint32_t index = static_cast<uint32_t>(features.size());
+  features.push_back(feature);
+  featureBounds.push_back(bounds);
+
+  const float reach = contact_reach();
+  const float cellSize = grid.cell_size();
+  const int minX = grid.cell_coord(bounds.min.x - reach);
+  const int maxX = grid.cell_coord(bounds.max.x + reach);
+  const int minZ = grid.cell_coord(bounds.min.z - reach);
+  const int maxZ = grid.cell_coord(bounds.max.z + reach);
+  for (int x = minX; x <= maxX; x++) {
+    for (int z = minZ; z <= maxZ; z++) {
+      entryPos.push_back({(x + 0.5f) * cellSize, 0.0f, (z + 0.5f) * cellSize});
+      entryFeature.push_back(index);
+    }
+  }
+
+  AABB& penBox = penBounds[feature.pen];
+  penBox.min.x = std::min(penBox.min.x, bounds.min.x - reach);
+  penBox.min.z = std::min(penBox.min.z, bounds.min.z - reach);
+  penBox.max.x = std::max(penBox.max.x, bounds.max.x + reach);
+  penBox.max.z = std::max(penBox.max.z, bounds.max.z + reach);
+}
+
+void FenceIndex::rebuild(const std::vector<std::unique_ptr<Pen>>& pens) {
+  features.clear();
+  featureBounds.clear();
+  entryPos.clear();
+  entryFeature.clear();
+  indexedPens.clear();
+  penBounds.assign(pens.size(), AABB{{1e30f, 0.0f, 1e30f},
+                                     {-1e30f, 0.0f, -1e30f}});
+
+  // Segments before posts within each pen, matching the order the pen pass
+  // has always resolved contacts in
+  for (uint32_t p = 0; p < pens.size(); p++) {
+    const Pen& pen = *pens[p];
+    indexedPens.push_back(&pen);
+    for (uint32_t i = 0; i < pen.edges.size(); i++) {
+      const RopeId edge = pen.edges[i];
+      for (uint32_t j = 0; j + 1 < pen.ropes->count(edge); j++) {
+        add_feature({p, i, j, false},
+                    segment_bounds(pen.ropes->point(edge, j),
+                                   pen.ropes->point(edge, j + 1), FENCE_SLACK));
+      }
+    }
+    for (uint32_t i = 0; i < pen.fixed_points.size(); i++) {
+      const vec3& post = pen.fixed_points[i];
+      add_feature({p, 0, i, true}, segment_bounds(post, post, 0.0f));
+    }
+  }
+
+  grid.build(entryPos.data(), entryPos.size());
+}
+
+bool FenceIndex::is_stale(
+    const std::vector<std::unique_ptr<Pen>>& pens) const {
+  if (pens.size() != indexedPens.size()) {
+    return true;
+  }
+  for (size_t p = 0; p < pens.size(); p++) {
+    if (pens[p].get() != indexedPens[p]) {
+      return true;
+    }
+  }
+  for (size_t f = 0; f < features.size(); f++) {
+    const Feature& feature = features[f];
+    if (feature.post) {
+      continue;  // Posts never move
+    }
+    const Pen& pen = *pens[feature.pen];
+    const RopeId edge = pen.edges[feature.edge];
+    if (!contains_xz(featureBounds[f], pen.ropes->point(edge, feature.point)) ||
+        !contains_xz(featureBounds[f],
+                     pen.ropes->point(edge, feature.point + 1))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void FenceIndex::refit(const std::vector<std::unique_ptr<Pen>>& pens) {
+  if (is_stale(pens)) {
+    rebuild(pens);
+  }
+}
+
+const SpatialGrid::Cell* FenceIndex::find(float x, float z) const {
+  return grid.find_cell(grid.cell_coord(x), grid.cell_coord(z));
+}
@@ -0,0 +1,128 @@
+#include "frustum.hpp"
+
+#include <cmath>
+
+#include "rlgl.h"
+#include "simd.hpp"
+
+void SphereArray::clear() {
+  x.clear();
+  y.clear();
+  z.clear();
+  radius.clear();
+}
+
+void SphereArray::add(const Vector3& center, float r) {
+  x.push_back(center.x);
+  y.push_back(center.y);
+  z.push_back(center.z);
+  radius.push_back(r);
+}
+
+static Vector4 normalize_plane(float a, float b, float c, float d) {
+  float length = std::sqrt(a * a + b * b + c * c);
+  return Vector4{a / length, b / length, c / length, d / length};
+}
+
+// Gribb and Hartmann: each plane is the last row of the matrix plus or minus
+// one of the others. raylib matrices are column-major, so row r of the
+// matrix as applied to a column vector is (m[r], m[r + 4], m[r + 8], ...).
+Frustum Frustum::from_matrix(const Matrix& viewProj) {
+  const float16 m = MatrixToFloatV(viewProj);
+  auto row = [&](int r, int i) { return m.v[r + 4 * i]; };
+  Frustum frustum;
+  for (int p = 0; p < 6; p++) {
+    int r = p / 2;
+    float sign = (p % 2 == 0) ? 1.0f : -1.0f;
+    frustum.planes[p] = normalize_plane(
+        row(3, 0) + sign * row(r, 0), row(3, 1) + sign * row(r, 1),
+        row(3, 2) + sign * row(r, 2), row(3, 3) + sign * row(r, 3));
+  }
+  return frustum;
+}
+
+Frustum Frustum::from_camera(const Camera3D& camera, float aspect) {
+  return from_matrix(camera_matrix(camera, aspect));
+}
+
+Frustum Frustum::from_current_matrices() {
+  return from_matrix(
+      MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection()));
+}
+
+Matrix camera_matrix(const Camera3D& camera, float aspect) {
+  Matrix view = MatrixLookAt(camera.position, camera.target, camera.up);
+  Matrix projection;
+  if (camera.projection == CAMERA_PERSPECTIVE) {
+    projection = MatrixPerspective(camera.fovy * DEG2RAD, aspect,
+                                   RL_CULL_DISTANCE_NEAR, RL_CULL_DISTANCE_FAR);
+  } else {
+    double top = camera.fovy / 2.0;
+    double right = top * aspect;
+    projection = MatrixOrtho(-right, right, -top, top, RL_CULL_DISTANCE_NEAR,
+                             RL_CULL_DISTANCE_FAR);
+  }
+  return MatrixMultiply(view, projection);
+}
+
+bool Frustum::intersects_box(const BoundingBox& box) const {
+  for (const Vector4& plane : planes) {
+    // The corner furthest along the plane normal
+    float x = plane.x >= 0.0f ? box.max.x : box.min.x;
+    float y = plane.y >= 0.0f ? box.max.y : box.min.y;
+    float z = plane.z >= 0.0f ? box.max.z : box.min.z;
+    if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0.0f) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Frustum::intersects_sphere(const Vector3& center, float radius) const {
+  for (const Vector4& plane : planes) {
+    if (plane.x * center.x + plane.y * center.y + plane.z * center.z +
+            plane.w <
+        -radius) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void Frustum::cull_spheres(const SphereArray& spheres,
+                           std::vector<uint32_t>& visible) const {
+  visible.clear();
+  simd::float4 a[6], b[6], c[6], d[6];
+  for (int p = 0; p < 6; p++) {
+    a[p] = simd::splat(planes[p].x);
+    b[p] = simd::splat(planes[p].y);
+    c[p] = simd::splat(planes[p].z);
+    d[p] = simd::splat(planes[p].w);
+  }
+  const simd::float4 zero = simd::splat(0.0f);
+  const size_t count = spheres.size();
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    simd::float4 x = simd::load(&spheres.x[i]);
+    simd::float4 y = simd::load(&spheres.y[i]);
+    simd::float4 z = simd::load(&spheres.z[i]);
+    simd::float4 below = zero - simd::load(&spheres.radius[i]);
+    // Bit i stays set while sphere i is inside every plane so far
+    int inside = 0xF;
+    for (int p = 0; p < 6; p++) {
+      simd::float4 distance = a[p] * x + b[p] * y + c[p] * z + d[p];
+      inside &= simd::mask_le(below, distance);
+    }
+    for (int lane = 0; lane < 4; lane++) {
+      if (inside & (1 << lane)) {
+        visible.push_back(static_cast<uint32_t>(i + lane));
+      }
+    }
+  }
+  for (; i < count; i++) {
+    Vector3 center = {spheres.x[i], spheres.y[i], spheres.z[i]};
+    if (intersects_sphere(center, spheres.radius[i])) {
+      visible.push_back(static_cast<uint32_t>(i));
+    }
+  }
+}
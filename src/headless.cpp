@@ -0,0 +1,308 @@
+// Windowless driver for the simulation: steps a fixed number of ticks from a
+// fixed seed and reports throughput, for profiling large herds, or replays
+// a recorded session as a benchmark.
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "animal.hpp"
+#include "buildings.hpp"
+#include "collectables.hpp"
+#include "input.hpp"
+#include "input_log.hpp"
+#include "pen_tracker.hpp"
+#include "physics.hpp"
+#include "player.hpp"
+#include "profiler.hpp"
+#include "simulation.hpp"
+#include "snapshot.hpp"
+#include "utils.hpp"
+
+struct HeadlessOptions {
+  int animals = 1000;
+  int ticks = 600;
+  int pens = 0;
+  unsigned int seed = 1;
+  int threads = 0;     // Collision job pool size; 0 uses every core
+  bool sweep = false;  // Time handle_collisions alone for growing herds
+  const char* replay = nullptr;  // Input log to rerun instead
+  const char* load = nullptr;    // Snapshot to start from
+  const char* save = nullptr;    // Where to write the final state
+  const char* trace = nullptr;   // Where to write the profile
+};
+
+static void print_usage(const char* program) {
+  printf(
+      "usage: %s [--animals N] [--ticks N] [--pens N] [--seed N]\n"
+      "          [--threads N] [--sweep] [--replay FILE]\n"
+      "          [--load FILE] [--save FILE] [--trace FILE]\n"
+      "  Steps the simulation without a window and prints ticks per second\n"
+      "  and a checksum of the final state (equal for any --threads).\n"
+      "  --sweep times handle_collisions for 1k animals doubling up to N.\n"
+      "  --replay reruns a session recorded with `wrangler --record FILE`,\n"
+      "  stopping at the first tick whose state differs from the recording.\n"
+      "  --load starts from a saved world instead of spawning one; --save\n"
+      "  writes the world after the last tick (also after --replay).\n"
+      "  --trace writes the profile as Chrome trace JSON (needs a build\n"
+      "  with -DWRANGLER_PROFILE=ON).\n",
+      program);
+}
+
+static bool parse_options(int argc, char** argv, HeadlessOptions& options) {
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    if (strcmp(arg, "--sweep") == 0) {
+      options.sweep = true;
+      continue;
+    }
+    if (i + 1 >= argc) {
+      return false;
+    }
+    if (strcmp(arg, "--replay") == 0) {
+      options.replay = argv[++i];
+      continue;
+    }
+    if (strcmp(arg, "--load") == 0) {
+      options.load = argv[++i];
+      continue;
+    }
+    if (strcmp(arg, "--save") == 0) {
+      options.save = argv[++i];
+      continue;
+    }
+    if (strcmp(arg, "--trace") == 0) {
+      options.trace = argv[++i];
+      continue;
+    }
+    long value = strtol(argv[++i], nullptr, 10);
+    if (strcmp(arg, "--animals") == 0) {
+      options.animals = static_cast<int>(value);
+    } else if (strcmp(arg, "--ticks") == 0) {
+      options.ticks = static_cast<int>(value);
+    } else if (strcmp(arg, "--pens") == 0) {
+      options.pens = static_cast<int>(value);
+    } else if (strcmp(arg, "--seed") == 0) {
+      options.seed = static_cast<unsigned int>(value);
+    } else if (strcmp(arg, "--threads") == 0) {
+      options.threads = static_cast<int>(value);
+    } else {
+      return false;
+    }
+  }
+  return options.animals > 0 && options.ticks > 0 && options.pens >= 0 &&
+         options.threads >= 0;
+}
+
+// Square pens laid out on a grid over the herd, closed the same way
+// Fence::place closes a fence (first point repeated at the end)
+static void create_pens(GameState& GameState, int count, float extent) {
+  int perRow = static_cast<int>(std::ceil(std::sqrt(count)));
+  float spacing = 2.0f * extent / perRow;
+  float half = spacing * 0.3f;
+  for (int i = 0; i < count; i++) {
+    float cx = -extent + spacing * (i % perRow + 0.5f);
+    float cz = -extent + spacing * (i / perRow + 0.5f);
+    std::vector<vec3> points = {
+        {cx - half, 1.0f, cz - half}, {cx + half, 1.0f, cz - half},
+        {cx + half, 1.0f, cz + half}, {cx - half, 1.0f, cz + half},
+        {cx - half, 1.0f, cz - half}};
+    GameState.pens.push_back(
+        std::make_unique<Pen>(points, *GameState.ropes));
+  }
+}
+
+// Keep the herd density of the default 50x50 spawn area as N grows
+static float spawn_extent(int animals) {
+  return std::max(25.0f, 25.0f * std::sqrt(animals / 1000.0f));
+}
+
+static void setup_state(GameState& GameState,
+                        const HeadlessOptions& options,
+                        int animals) {
+  float extent = spawn_extent(animals);
+  GameState.animals->clear();
+  spawn_animals(*GameState.animals, GameState.spawnRandom, animals, extent);
+  create_pens(GameState, options.pens, extent);
+  // No new animals mid-run so every tick works on the same population
+  GameState.addAnimalInterval = 1e30f;
+}
+
+// Per-tick cost of handle_collisions alone as the herd doubles
+static void run_collision_sweep(const HeadlessOptions& options) {
+  printf("%10s %14s %16s %14s %14s\n", "animals", "ms/tick",
+         "us/animal/tick", "pairs/tick", "contacts/tick");
+  int threads = 0;
+  for (int animals = 1000; animals <= options.animals; animals *= 2) {
+    GameState GameState(1280, 720, options.threads, options.seed);
+    setup_state(GameState, options, animals);
+    SimInput input;
+    // Fixed, so every herd size is measured with the same amount of work
+    const int substeps = MAX_SUBSTEPS;
+
+    threads = GameState.jobs->thread_count();
+
+    CollisionStats stats;
+    auto start = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < options.ticks; tick++) {
+      handle_collisions(GameState, input, substeps);
+      stats.pairsTested += GameState.collisionStats.pairsTested;
+      stats.contactsResolved += GameState.collisionStats.contactsResolved;
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double ms = std::chrono::duration<double, std::milli>(end - start).count() /
+                options.ticks;
+    printf("%10d %14.3f %16.3f %14llu %14llu\n", animals, ms,
+           1000.0 * ms / animals,
+           static_cast<unsigned long long>(stats.pairsTested / options.ticks),
+           static_cast<unsigned long long>(stats.contactsResolved /
+                                           options.ticks));
+  }
+  printf("threads %d\n", threads);
+}
+
+// Write the world to `path` if one was given; returns the exit status
+static int save_world(const GameState& GameState, const char* path) {
+  if (!path) {
+    return 0;
+  }
+  try {
+    write_snapshot_file(path, capture_snapshot(GameState), true);
+  } catch (const std::exception& e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
+
+// Write every event the profiler still holds to `path` if one was given;
+// returns the exit status
+static int write_trace(const char* path) {
+  if (!path || Profiler::write_chrome_trace(path, 1e6)) {
+    return 0;
+  }
+  fprintf(stderr, "cannot write %s\n", path);
+  return 1;
+}
+
+// Rerun a recorded session, checking the state after every tick against
+// the checksum logged for it. Only step_simulation is timed.
+static int run_replay(const HeadlessOptions& options) {
+  InputLog log;
+  try {
+    log = load_input_log(options.replay);
+  } catch (const std::exception& e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+
+  GameState GameState(1280, 720, options.threads, log.seed);
+  double seconds = 0.0;
+  for (size_t tick = 0; tick < log.inputs.size(); tick++) {
+    auto start = std::chrono::steady_clock::now();
+    step_simulation(GameState, log.inputs[tick]);
+    auto end = std::chrono::steady_clock::now();
+    seconds += std::chrono::duration<double>(end - start).count();
+
+    uint32_t checksum = static_cast<uint32_t>(state_checksum(GameState));
+    if (checksum != log.checksums[tick]) {
+      printf("diverged at tick %zu: recorded %08x, replayed %08x\n", tick,
+             log.checksums[tick], checksum);
+      return 2;
+    }
+  }
+
+  const size_t ticks = log.inputs.size();
+  printf("replayed %zu ticks (%.1f s of play)  seed %llu  threads %d\n",
+         ticks, ticks * PHYSICS_TIME,
+         static_cast<unsigned long long>(log.seed),
+         GameState.jobs->thread_count());
+  printf("%.3f s simulating, %.3f ms/tick, %zu animals at the end\n",
+         seconds, ticks ? 1000.0 * seconds / ticks : 0.0,
+         GameState.animals->size());
+  printf("checksum %016llx\n",
+         static_cast<unsigned long long>(state_checksum(GameState)));
+  if (int status = write_trace(options.trace)) {
+    return status;
+  }
+  return save_world(GameState, options.save);
+}
+
+int main(int argc, char** argv) {
+  HeadlessOptions options;
+  if (!parse_options(argc, argv, options)) {
+    print_usage(argv[0]);
+    return 1;
+  }
+#if !WRANGLER_PROFILE
+  if (options.trace) {
+    fprintf(stderr, "--trace needs a build with -DWRANGLER_PROFILE=ON\n");
+    return 1;
+  }
+#endif
+  PROFILE_THREAD("Main");
+
+  SetTraceLogLevel(LOG_WARNING);
+  if (options.sweep) {
+    run_collision_sweep(options);
+    return 0;
+  }
+  if (options.replay) {
+    return run_replay(options);
+  }
+
+  GameState GameState(1280, 720, options.threads, options.seed);
+  try {
+    if (options.load) {
+      load_snapshot_file(GameState, options.load);
+    } else {
+      setup_state(GameState, options, options.animals);
+    }
+  } catch (const std::exception& e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+
+  SimInput input;
+
+  CollisionStats stats;
+  uint64_t substeps = 0;
+  uint64_t penEvents = 0;
+  uint64_t polygonTests = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int tick = 0; tick < options.ticks; tick++) {
+    substeps += GameState.substeps;
+    step_simulation(GameState, input);
+    stats.pairsTested += GameState.collisionStats.pairsTested;
+    stats.contactsResolved += GameState.collisionStats.contactsResolved;
+    penEvents += GameState.penTracker->events().size();
+    polygonTests += GameState.penTracker->polygon_tests();
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  double seconds = std::chrono::duration<double>(end - start).count();
+  printf("animals %zu  pens %zu  ticks %d  seed %llu  threads %d\n",
+         GameState.animals->size(), GameState.pens.size(), options.ticks,
+         static_cast<unsigned long long>(GameState.seed),
+         GameState.jobs->thread_count());
+  printf("%.3f s total, %.3f ms/tick, %.1f ticks/s\n", seconds,
+         1000.0 * seconds / options.ticks, options.ticks / seconds);
+  printf("%.0f pair tests/tick, %.0f contacts/tick, %.2f substeps/tick\n",
+         static_cast<double>(stats.pairsTested) / options.ticks,
+         static_cast<double>(stats.contactsResolved) / options.ticks,
+         static_cast<double>(substeps) / options.ticks);
+  printf("%llu pen enter/exit events, %.0f polygon tests/tick\n",
+         static_cast<unsigned long long>(penEvents),
+         static_cast<double>(polygonTests) / options.ticks);
+  printf("%d coins collected, %zu on the ground\n", GameState.coins,
+         GameState.coinPool->size());
+  printf("checksum %016llx\n",
+         static_cast<unsigned long long>(state_checksum(GameState)));
+  if (int status = write_trace(options.trace)) {
+    return status;
+  }
+  return save_world(GameState, options.save);
+}
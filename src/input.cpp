@@ -0,0 +1,23 @@
+#include "input.hpp"
+
+SimInput poll_input(const Camera3D& camera, int tool) {
+  SimInput input;
+  input.forward = IsKeyDown(KEY_W);
+  input.back = IsKeyDown(KEY_S);
+  input.left = IsKeyDown(KEY_A);
+  input.right = IsKeyDown(KEY_D);
+  input.ropeSlack = IsKeyDown(KEY_LEFT_SHIFT);
+  input.mouseLeft = IsMouseButtonDown(MOUSE_BUTTON_LEFT);
+  input.mouseRay = GetMouseRay(GetMousePosition(), camera);
+  input.tool = tool;
+#if defined(_WIN32) || defined(_WIN64)
+  input.zoom = 3 * GetMouseWheelMove();
+#else
+  input.zoom = GetMouseWheelMove();
+#endif
+  if (tool == 1) {
+    input.placeFence = IsMouseButtonPressed(MOUSE_BUTTON_LEFT);
+    input.undoFence = IsMouseButtonPressed(MOUSE_BUTTON_RIGHT);
+  }
+  return input;
+}
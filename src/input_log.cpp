@@ -0,0 +1,119 @@
+#include "input_log.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+static const char LOG_MAGIC[4] = {'W', 'R', 'I', 'L'};
+static const uint32_t LOG_VERSION = 1;
+
+// Bits of the buttons byte
+enum : uint8_t {
+  BUTTON_FORWARD = 1 << 0,
+  BUTTON_BACK = 1 << 1,
+  BUTTON_LEFT = 1 << 2,
+  BUTTON_RIGHT = 1 << 3,
+  BUTTON_ROPE_SLACK = 1 << 4,
+  BUTTON_MOUSE_LEFT = 1 << 5,
+  BUTTON_PLACE_FENCE = 1 << 6,
+  BUTTON_UNDO_FENCE = 1 << 7,
+};
+
+// The flags byte: selected tool in the low bits, then whether a ray follows
+static const uint8_t FLAG_TOOL_MASK = 0x0f;
+static const uint8_t FLAG_RAY = 0x80;
+
+template <typename T>
+static void write_raw(std::ofstream& out, const T& value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static bool read_raw(std::ifstream& in, T& value) {
+  return static_cast<bool>(in.read(reinterpret_cast<char*>(&value),
+                                   sizeof(T)));
+}
+
+static bool same_ray(const Ray& a, const Ray& b) {
+  return std::memcmp(&a, &b, sizeof(Ray)) == 0;
+}
+
+InputRecorder::InputRecorder(const std::string& path, uint64_t seed)
+    : out(path, std::ios::binary | std::ios::trunc),
+      lastRay(SimInput{}.mouseRay) {
+  if (!out) {
+    throw std::runtime_error("cannot create input log " + path);
+  }
+  out.write(LOG_MAGIC, sizeof(LOG_MAGIC));
+  write_raw(out, LOG_VERSION);
+  write_raw(out, seed);
+}
+
+void InputRecorder::record(const SimInput& input, uint64_t checksum) {
+  uint8_t buttons = (input.forward ? BUTTON_FORWARD : 0) |
+                    (input.back ? BUTTON_BACK : 0) |
+                    (input.left ? BUTTON_LEFT : 0) |
+                    (input.right ? BUTTON_RIGHT : 0) |
+                    (input.ropeSlack ? BUTTON_ROPE_SLACK : 0) |
+                    (input.mouseLeft ? BUTTON_MOUSE_LEFT : 0) |
+                    (input.placeFence ? BUTTON_PLACE_FENCE : 0) |
+                    (input.undoFence ? BUTTON_UNDO_FENCE : 0);
+  const bool rayChanged = !same_ray(input.mouseRay, lastRay);
+  uint8_t flags = static_cast<uint8_t>(input.tool) & FLAG_TOOL_MASK;
+  if (rayChanged) {
+    flags |= FLAG_RAY;
+  }
+  write_raw(out, buttons);
+  write_raw(out, flags);
+  if (rayChanged) {
+    write_raw(out, input.mouseRay);
+    lastRay = input.mouseRay;
+  }
+  write_raw(out, static_cast<uint32_t>(checksum));
+  tickCount++;
+}
+
+InputLog load_input_log(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error("cannot open input log " + path);
+  }
+  char magic[4];
+  uint32_t version = 0;
+  InputLog log;
+  if (!in.read(magic, sizeof(magic)) ||
+      std::memcmp(magic, LOG_MAGIC, sizeof(magic)) != 0 ||
+      !read_raw(in, version) || !read_raw(in, log.seed)) {
+    throw std::runtime_error(path + " is not an input log");
+  }
+  if (version != LOG_VERSION) {
+    throw std::runtime_error(path + ": unsupported input log version " +
+                             std::to_string(version));
+  }
+
+  Ray ray = SimInput{}.mouseRay;
+  uint8_t buttons;
+  uint8_t flags;
+  while (read_raw(in, buttons) && read_raw(in, flags)) {
+    if ((flags & FLAG_RAY) && !read_raw(in, ray)) {
+      break;
+    }
+    uint32_t checksum;
+    if (!read_raw(in, checksum)) {
+      break;
+    }
+    SimInput input;
+    input.forward = buttons & BUTTON_FORWARD;
+    input.back = buttons & BUTTON_BACK;
+    input.left = buttons & BUTTON_LEFT;
+    input.right = buttons & BUTTON_RIGHT;
+    input.ropeSlack = buttons & BUTTON_ROPE_SLACK;
+    input.mouseLeft = buttons & BUTTON_MOUSE_LEFT;
+    input.placeFence = buttons & BUTTON_PLACE_FENCE;
+    input.undoFence = buttons & BUTTON_UNDO_FENCE;
+    input.tool = flags & FLAG_TOOL_MASK;
+    input.mouseRay = ray;
+    log.inputs.push_back(input);
+    log.checksums.push_back(checksum);
+  }
+  return log;
+}
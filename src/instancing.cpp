@@ -0,0 +1,116 @@
+#include "instancing.hpp"
+
+#include "rlgl.h"
+
+void InstanceBatch::clear() {
+  transforms.clear();
+  colors.clear();
+  dirty = true;
+}
+
+void InstanceBatch::add(const Matrix& transform, Color color) {
+  transforms.push_back(MatrixToFloatV(transform));
+  colors.push_back(color);
+  dirty = true;
+}
+
+void InstanceBatch::upload() {
+  const size_t count = size();
+  if (count > capacity) {
+    // Grow geometrically so a growing herd reallocates rarely
+    unload();
+    capacity = count * 2;
+    transformVbo = rlLoadVertexBuffer(
+        nullptr, static_cast<int>(capacity * sizeof(float16)), true);
+    colorVbo = rlLoadVertexBuffer(
+        nullptr, static_cast<int>(capacity * sizeof(Color)), true);
+  }
+  rlUpdateVertexBuffer(transformVbo, transforms.data(),
+                       static_cast<int>(count * sizeof(float16)), 0);
+  rlUpdateVertexBuffer(colorVbo, colors.data(),
+                       static_cast<int>(count * sizeof(Color)), 0);
+  dirty = false;
+}
+
+void InstanceBatch::draw(const Mesh& mesh,
+                         const Material& material,
+                         int colorLoc) {
+  if (transforms.empty()) {
+    return;
+  }
+  if (dirty) {
+    upload();
+  }
+
+  const Shader& shader = material.shader;
+  rlEnableShader(shader.id);
+
+  // Instance colors carry the tint, so the material color is left white
+  if (shader.locs[SHADER_LOC_COLOR_DIFFUSE] != -1) {
+    float white[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    rlSetUniform(shader.locs[SHADER_LOC_COLOR_DIFFUSE], white,
+                 SHADER_UNIFORM_VEC4, 1);
+  }
+  // The shader multiplies by texture0. Whatever was drawn last may have
+  // left slot 0 empty, so bind the material's texture (white by default).
+  unsigned int texture = material.maps[MATERIAL_MAP_DIFFUSE].texture.id;
+  rlActiveTextureSlot(0);
+  rlEnableTexture(texture != 0 ? texture : rlGetTextureIdDefault());
+
+  Matrix matView = rlGetMatrixModelview();
+  Matrix matProjection = rlGetMatrixProjection();
+  Matrix matModelView = MatrixMultiply(rlGetMatrixTransform(), matView);
+  if (shader.locs[SHADER_LOC_MATRIX_VIEW] != -1) {
+    rlSetUniformMatrix(shader.locs[SHADER_LOC_MATRIX_VIEW], matView);
+  }
+  if (shader.locs[SHADER_LOC_MATRIX_PROJECTION] != -1) {
+    rlSetUniformMatrix(shader.locs[SHADER_LOC_MATRIX_PROJECTION],
+                       matProjection);
+  }
+
+  // Point the instance attributes at our buffers. Done every draw since
+  // several batches may share one mesh (and so one VAO).
+  rlEnableVertexArray(mesh.vaoId);
+  rlEnableVertexBuffer(transformVbo);
+  const int modelLoc = shader.locs[SHADER_LOC_MATRIX_MODEL];
+  for (int i = 0; i < 4; i++) {
+    rlEnableVertexAttribute(modelLoc + i);
+    rlSetVertexAttribute(modelLoc + i, 4, RL_FLOAT, false, sizeof(float16),
+                         (void*)(i * sizeof(Vector4)));
+    rlSetVertexAttributeDivisor(modelLoc + i, 1);
+  }
+  if (colorLoc != -1) {
+    rlEnableVertexBuffer(colorVbo);
+    rlEnableVertexAttribute(colorLoc);
+    rlSetVertexAttribute(colorLoc, 4, RL_UNSIGNED_BYTE, true, sizeof(Color),
+                         nullptr);
+    rlSetVertexAttributeDivisor(colorLoc, 1);
+  }
+
+  rlSetUniformMatrix(shader.locs[SHADER_LOC_MATRIX_MVP],
+                     MatrixMultiply(matModelView, matProjection));
+  const int instances = static_cast<int>(size());
+  if (mesh.indices != nullptr) {
+    rlDrawVertexArrayElementsInstanced(0, mesh.triangleCount * 3, nullptr,
+                                       instances);
+  } else {
+    rlDrawVertexArrayInstanced(0, mesh.vertexCount, instances);
+  }
+
+  rlDisableVertexArray();
+  rlDisableVertexBuffer();
+  rlDisableVertexBufferElement();
+  rlDisableTexture();
+  rlDisableShader();
+}
+
+void InstanceBatch::unload() {
+  if (transformVbo != 0) {
+    rlUnloadVertexBuffer(transformVbo);
+    rlUnloadVertexBuffer(colorVbo);
+  }
+  transformVbo = 0;
+  colorVbo = 0;
+  capacity = 0;
+  dirty = true;
+}
@@ -0,0 +1,96 @@
+#include "jobs.hpp"
+
+#include <algorithm>
+
+#include "profiler.hpp"
+
+JobSystem::JobSystem(int threadCount) {
+#if defined(__EMSCRIPTEN__)
+  threadCount = 1;  // The web build is not compiled with pthreads
+#endif
+  if (threadCount <= 0) {
+    threadCount = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (int i = 1; i < threadCount; i++) {
+    workers.emplace_back(&JobSystem::worker_loop, this);
+  }
+}
+
+JobSystem::~JobSystem() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+void JobSystem::run_chunks() {
+  for (;;) {
+    size_t chunk = nextChunk.fetch_add(1, std::memory_order_relaxed);
+    if (chunk >= jobChunks) {
+      return;
+    }
+    size_t begin = chunk * jobGrain;
+    (*job)(begin, std::min(begin + jobGrain, jobCount));
+  }
+}
+
+void JobSystem::worker_loop() {
+  PROFILE_THREAD("Job worker");
+  uint64_t seen = 0;
+  std::unique_lock<std::mutex> lock(mutex);
+  for (;;) {
+    wake.wait(lock, [&] { return stopping || generation != seen; });
+    if (stopping) {
+      return;
+    }
+    seen = generation;
+    joined++;
+    running++;
+    lock.unlock();
+
+    {
+      PROFILE_SCOPE("Job");
+      run_chunks();
+    }
+
+    lock.lock();
+    running--;
+    done.notify_one();
+  }
+}
+
+void JobSystem::parallel_for(size_t count, size_t grain, const RangeFn& fn) {
+  if (count == 0) {
+    return;
+  }
+  grain = std::max<size_t>(grain, 1);
+  if (workers.empty() || count <= grain) {
+    fn(0, count);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    job = &fn;
+    jobCount = count;
+    jobGrain = grain;
+    jobChunks = (count + grain - 1) / grain;
+    nextChunk.store(0, std::memory_order_relaxed);
+    joined = 0;
+    generation++;
+  }
+  wake.notify_all();
+
+  run_chunks();
+
+  // Wait for every worker to have joined and left this generation, so none
+  // can still be holding a chunk index when the next loop resets the counter
+  std::unique_lock<std::mutex> lock(mutex);
+  const int workerCount = static_cast<int>(workers.size());
+  done.wait(lock, [&] { return joined == workerCount && running == 0; });
+  job = nullptr;
+}
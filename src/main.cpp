@@ -3,100 +3,152 @@
 #include "rlgl.h"
 #define RAYGUI_IMPLEMENTATION
 #include <array>
+#include <cstring>
 #include <iostream>
 #include <limits>
 #include <random>
+#include <stdexcept>
 #include <vector>
 
 #include "animal.hpp"
 #include "buildings.hpp"
+#include "input.hpp"
+#include "input_log.hpp"
 #include "physics.hpp"
 #include "player.hpp"
+#include "profiler.hpp"
 #include "raygui.h"
 #include "render_utils.hpp"
+#include "sim_thread.hpp"
+#include "simulation.hpp"
+#include "snapshot.hpp"
 #include "terrain.hpp"
 #include "utils.hpp"
 
-const float PHYSICS_TIME = 1.0 / 60.0;
+// One autosave a minute (60 ticks a second)
+const uint64_t AUTOSAVE_TICKS = 60 * 60;
+// F4 writes this much of the profile to trace.json
+const double TRACE_DUMP_SECONDS = 10.0;
+
+// F3 cycles High, Low, Off
+static RenderUtils::DofQuality next_dof_quality(
+    RenderUtils::DofQuality quality) {
+  switch (quality) {
+    case RenderUtils::DofQuality::HIGH:
+      return RenderUtils::DofQuality::LOW;
+    case RenderUtils::DofQuality::LOW:
+      return RenderUtils::DofQuality::OFF;
+    default:
+      return RenderUtils::DofQuality::HIGH;
+  }
+}
+
+static const char* dof_quality_name(RenderUtils::DofQuality quality) {
+  switch (quality) {
+    case RenderUtils::DofQuality::HIGH:
+      return "high";
+    case RenderUtils::DofQuality::LOW:
+      return "low";
+    default:
+      return "off";
+  }
+}
 
 void GameLoop(vec3 lightDir,
               RenderTexture2D& shadowMap,
-              rl::Shader& shadowShader,
-              rl::Shader& dofShader,
-              RenderTexture2D& dofTexture,
+              RenderUtils::DofPass& dof,
               int screenWidth,
               int screenHeight,
-              GameState& GameState) {
-  float accumulator = 0.0;
-  int substeps = 8;
+              RenderUtils::FrameState& frame,
+              RenderUtils::SceneAssets& assets,
+              SimThread& sim) {
+  PROFILE_THREAD("Main");
   while (!WindowShouldClose()) {
+    PROFILE_SCOPE("Frame");
     float dt = GetFrameTime();
-
-    handle_building(GameState, GameState.camera);
-    accumulator += dt;
-    while (accumulator >= PHYSICS_TIME) {
-      // Update game state
-      GameState.mouse_proj = project_mouse(1.0, GameState.camera);
-      handle_collisions(GameState, substeps, GameState.pens);
-      GameState.player->tether.update(GameState.camera, GameState,
-                                      GameState.player->pos);
-      GameState.player->update();
-      GameState.player->rope.update(GameState.player->pos,
-                                    GameState.player->tether.pos, dt);
-      GameState.addAnimalTimer += dt;
-      if (GameState.addAnimalTimer > GameState.addAnimalInterval) {
-        GameState.addAnimalTimer = 0.0;
-        GameState.addAnimal(shadowShader);
-      }
-      for (auto& animal : GameState.animals) {
-        animal->update();
-      }
-      for (auto& pen : GameState.pens) {
-        pen->update(GameState, dt);
+    if (IsKeyPressed(KEY_F3)) {
+      RenderUtils::SetDofQuality(dof, next_dof_quality(dof.quality));
+      TraceLog(LOG_INFO, "Depth of field: %s",
+               dof_quality_name(dof.quality));
+    }
+#if WRANGLER_PROFILE
+    if (IsKeyPressed(KEY_F4)) {
+      if (Profiler::write_chrome_trace("trace.json", TRACE_DUMP_SECONDS)) {
+        TraceLog(LOG_INFO, "Wrote the last %.0f s of profile to trace.json",
+                 TRACE_DUMP_SECONDS);
+      } else {
+        TraceLog(LOG_WARNING, "Cannot write trace.json");
       }
-      GameState.terrain->update(GameState, dt);
-      detect_animals_in_pens(GameState.pens, GameState.animals);
-      RenderUtils::update_camera(GameState);
-      // Update shaders
-      Vector3 cameraPos = GameState.camera.position;
-      SetShaderValue(shadowShader, shadowShader.locs[SHADER_LOC_VECTOR_VIEW],
-                     &cameraPos, SHADER_UNIFORM_VEC3);
-
-      update_lightDir(lightDir, dt);
-      update_itemActive(GameState.itemActive);
-
-      accumulator -= PHYSICS_TIME;
     }
+#endif
+
+    // The mouse aims through the view last drawn, which is what the
+    // player saw
+    update_itemActive(frame.itemActive);
+    sim.send(poll_input(frame.view, frame.itemActive));
+    sim.update();
+
+    // Draw between the newest tick and the one before, however far the
+    // sim's clock has got
+    const RenderSnapshot& snapshot = sim.latest();
+    frame.snapshot = &snapshot;
+    frame.alpha = sim.alpha(snapshot);
+    frame.view = RenderUtils::blend_camera(snapshot.previous, snapshot.camera,
+                                           frame.alpha);
+    frame.mouse_proj = project_mouse(1.0, frame.view);
+    Camera3D view = frame.view;
+
+    // Grass sway and the light are cosmetic, so they follow frame time
+    assets.terrain->update(view.target, dt);
+    update_lightDir(lightDir, dt);
     lightDir = Vector3Normalize(lightDir);
-    GameState.lightCam.position = Vector3Scale(lightDir, -15.0f);
-    int lightDirLoc = GetShaderLocation(shadowShader, "lightDir");
-    SetShaderValue(shadowShader, lightDirLoc, &lightDir, SHADER_UNIFORM_VEC3);
+    // The shadow map covers the area around what the camera looks at
+    frame.lightCam.target = view.target;
+    frame.lightCam.position =
+        Vector3Add(view.target, Vector3Scale(lightDir, -15.0f));
+    RenderUtils::update_uniforms(assets, view, frame.lightCam, lightDir);
 
-    RenderUtils::RenderShadowMap(shadowShader, shadowMap, GameState.lightCam,
-                                 GameState);
+    RenderUtils::collect_instances(frame, assets);
+
+    RenderUtils::RenderShadowMap(shadowMap, frame.lightCam, frame, assets);
 
     // Render scene
-    RenderUtils::RenderSceneToTexture(dofTexture, GameState.camera,
-                                      shadowShader, shadowMap, GameState);
+    RenderUtils::RenderSceneToTexture(dof.scene, view, shadowMap, frame,
+                                      assets);
 
-    RenderUtils::HandleWindowResize(GameState, screenWidth, screenHeight,
-                                    dofTexture, dofShader);
+    RenderUtils::HandleWindowResize(frame, screenWidth, screenHeight, dof);
 
     // Render final image
     BeginDrawing();
     ClearBackground(RAYWHITE);
-    BeginShaderMode(dofShader);
-    DrawTexture(dofTexture.texture, 0, 0, WHITE);
-    EndShaderMode();
-    RenderUtils::DrawGUI(GameState, screenWidth, screenHeight);
+    {
+      PROFILE_SCOPE("DoF pass");
+      RenderUtils::RenderDof(dof);
+    }
+    RenderUtils::DrawGUI(frame, screenWidth, screenHeight);
     DrawFPS(10, 10);
-    EndDrawing();
+    {
+      // Includes waiting for vsync
+      PROFILE_SCOPE("Present");
+      EndDrawing();
+    }
   }
 }
 
-int main(void) {
+int main(int argc, char** argv) {
   int screenWidth = 1280;
   int screenHeight = 720;
+  // --record FILE logs every tick's input for wrangler_headless --replay;
+  // --load FILE continues a saved world, such as the autosave
+  const char* recordPath = nullptr;
+  const char* loadPath = nullptr;
+  for (int i = 1; i + 1 < argc; i++) {
+    if (strcmp(argv[i], "--record") == 0) {
+      recordPath = argv[++i];
+    } else if (strcmp(argv[i], "--load") == 0) {
+      loadPath = argv[++i];
+    }
+  }
 
   try {
     RenderUtils::InitializeWindow(screenWidth, screenHeight);
@@ -107,12 +159,39 @@ int main(void) {
     GuiSetStyle(DEFAULT, TEXT_SIZE, 26);  // Adjust size as needed
 
     vec3 lightDir = Vector3Normalize((Vector3){0.35f, -1.0f, -0.35f});
-    RenderTexture2D dofTexture =
-        RenderUtils::SetupDofTexture(screenWidth, screenHeight);
-    rl::Shader dofShader =
+    RenderUtils::DofPass dof =
         RenderUtils::SetupDofShader(screenWidth, screenHeight);
-    rl::Shader shadowShader = RenderUtils::SetupShadowShader(lightDir);
-    GameState GameState(shadowShader, screenWidth, screenHeight);
+    rl::Shader shadowShader = RenderUtils::SetupShadowShader();
+    // A fresh herd every launch; the seed is logged so a run can be redone
+    std::random_device entropy;
+    uint64_t seed = (static_cast<uint64_t>(entropy()) << 32) | entropy();
+    TraceLog(LOG_INFO, "Simulation seed: %llu",
+             static_cast<unsigned long long>(seed));
+    GameState GameState(screenWidth, screenHeight, 0, seed);
+    if (loadPath) {
+      load_snapshot_file(GameState, loadPath);
+      TraceLog(LOG_INFO, "Loaded %s at tick %llu", loadPath,
+               static_cast<unsigned long long>(GameState.tick));
+    }
+    Autosave autosave("autosave.wsav", AUTOSAVE_TICKS);
+    std::unique_ptr<InputRecorder> recorder;
+    if (recordPath) {
+      // A replay starts from a fresh world, so a loaded one is not logged
+      if (loadPath) {
+        throw std::runtime_error("--record cannot be combined with --load");
+      }
+      recorder = std::make_unique<InputRecorder>(recordPath, seed);
+      TraceLog(LOG_INFO, "Recording input to %s", recordPath);
+    }
+    GameState.camera = RenderUtils::SetupCamera();
+    RenderUtils::FrameState frame;
+    frame.view = GameState.camera;
+    frame.lightCam = RenderUtils::SetupLightCamera();
+    frame.itemActive = GameState.itemActive;
+    frame.screenWidth = screenWidth;
+    frame.screenHeight = screenHeight;
+    RenderUtils::SceneAssets assets =
+        RenderUtils::LoadSceneAssets(shadowShader, lightDir);
 
     RenderTexture2D shadowMap = RenderUtils::LoadShadowmapRenderTexture(
         SHADOWMAP_RESOLUTION, SHADOWMAP_RESOLUTION);
@@ -123,11 +202,17 @@ int main(void) {
 
     SetExitKey(KEY_NULL);
 
-    GameLoop(lightDir, shadowMap, shadowShader, dofShader, dofTexture,
-             screenWidth, screenHeight, GameState);
+    {
+      // From here until it stops, GameState belongs to the sim thread
+      SimThread sim(GameState, recorder.get(), autosave);
+      GameLoop(lightDir, shadowMap, dof, screenWidth, screenHeight, frame,
+               assets, sim);
+    }
 
-    RenderUtils::UnloadResources(shadowShader, shadowMap, GameState, dofShader,
-                                 dofTexture);
+    TraceLog(LOG_INFO, "Uniforms: %llu sent, %llu redundant sets skipped",
+             static_cast<unsigned long long>(ShaderProgram::total_sent()),
+             static_cast<unsigned long long>(ShaderProgram::total_skipped()));
+    RenderUtils::UnloadResources(shadowShader, shadowMap, assets, dof);
     UnloadFont(customFont);
   } catch (const std::exception& e) {
     TraceLog(LOG_ERROR, "An error occurred: %s", e.what());
@@ -0,0 +1,222 @@
+#include "pen_tracker.hpp"
+
+#include <algorithm>
+
+// Coarser cells mean fewer entries but more animals in boundary cells
+static const float PEN_CELL_SIZE = 2.0f;
+
+PenTracker::PenTracker() : grid(PEN_CELL_SIZE) {}
+
+// Same crossing test as is_point_in_polygon, with the divide done up front
+bool PenTracker::contains(const Shape& shape, float x, float z) const {
+  if (x < shape.bounds.min.x || x > shape.bounds.max.x ||
+      z < shape.bounds.min.z || z > shape.bounds.max.z) {
+    return false;
+  }
+  int intersections = 0;
+  for (const Edge& edge : shape.edges) {
+    if ((z > edge.startZ) != (z > edge.endZ)) {
+      float intersectionX = edge.startX + (z - edge.startZ) * edge.slope;
+      if (x < intersectionX) {
+        intersections++;
+      }
+    }
+  }
+  return intersections % 2 == 1;
+}
+
+bool PenTracker::pens_changed(
+    const std::vector<std::unique_ptr<Pen>>& pens) const {
+  if (pens.size() != trackedPens.size()) {
+    return true;
+  }
+  for (size_t p = 0; p < pens.size(); p++) {
+    if (pens[p].get() != trackedPens[p]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void PenTracker::rebuild(std::vector<std::unique_ptr<Pen>>& pens,
+                         const AnimalPool& animals) {
+  // Pens are only ever appended; anything else invalidates what we know
+  bool appended = trackedPens.size() <= pens.size();
+  for (size_t p = 0; appended && p < trackedPens.size(); p++) {
+    appended = pens[p].get() == trackedPens[p];
+  }
+  if (!appended) {
+    for (auto& pen : pens) {
+      pen->contained_animals.clear();
+      pen->updateSpecies(animals);
+    }
+    for (SlotState& state : slots) {
+      state.pens.clear();
+    }
+  }
+  for (SlotState& state : slots) {
+    state.needsTest = true;
+  }
+
+  shapes.clear();
+  trackedPens.clear();
+  entryPos.clear();
+  entries.clear();
+  for (uint32_t p = 0; p < pens.size(); p++) {
+    const std::vector<vec3>& points = pens[p]->fixed_points;
+    trackedPens.push_back(pens[p].get());
+
+    Shape shape;
+    shape.bounds = {points[0], points[0]};
+    for (size_t i = 0; i < points.size(); i++) {
+      const vec3& start = points[i];
+      const vec3& end = points[(i + 1) % points.size()];
+      shape.bounds.min.x = std::min(shape.bounds.min.x, start.x);
+      shape.bounds.min.z = std::min(shape.bounds.min.z, start.z);
+      shape.bounds.max.x = std::max(shape.bounds.max.x, start.x);
+      shape.bounds.max.z = std::max(shape.bounds.max.z, start.z);
+      // Edges parallel to x never count as a crossing
+      if (start.z != end.z) {
+        shape.edges.push_back({start.x, start.z, end.z,
+                               (end.x - start.x) / (end.z - start.z)});
+      }
+    }
+
+    // Classify every cell under the pen: boundary when an edge's box
+    // touches it, otherwise inside or outside as its center is
+    const int minX = grid.cell_coord(shape.bounds.min.x);
+    const int maxX = grid.cell_coord(shape.bounds.max.x);
+    const int minZ = grid.cell_coord(shape.bounds.min.z);
+    const int maxZ = grid.cell_coord(shape.bounds.max.z);
+    for (int x = minX; x <= maxX; x++) {
+      for (int z = minZ; z <= maxZ; z++) {
+        const float cellMinX = x * PEN_CELL_SIZE;
+        const float cellMinZ = z * PEN_CELL_SIZE;
+        const float cellMaxX = cellMinX + PEN_CELL_SIZE;
+        const float cellMaxZ = cellMinZ + PEN_CELL_SIZE;
+        bool boundary = false;
+        for (size_t i = 0; i < points.size() && !boundary; i++) {
+          const vec3& start = points[i];
+          const vec3& end = points[(i + 1) % points.size()];
+          boundary = std::max(start.x, end.x) >= cellMinX &&
+                     std::min(start.x, end.x) <= cellMaxX &&
+                     std::max(start.z, end.z) >= cellMinZ &&
+                     std::min(start.z, end.z) <= cellMaxZ;
+        }
+        vec3 center = {cellMinX + 0.5f * PEN_CELL_SIZE, 0.0f,
+                       cellMinZ + 0.5f * PEN_CELL_SIZE};
+        if (boundary || contains(shape, center.x, center.z)) {
+          entryPos.push_back(center);
+          entries.push_back({p, boundary});
+        }
+      }
+    }
+    shapes.push_back(std::move(shape));
+  }
+  grid.build(entryPos.data(), entryPos.size());
+}
+
+void PenTracker::update_slot(SlotState& state,
+                             AnimalHandle handle,
+                             const vec3& pos,
+                             std::vector<std::unique_ptr<Pen>>& pens) {
+  state.cellX = grid.cell_coord(pos.x);
+  state.cellZ = grid.cell_coord(pos.z);
+  state.needsTest = false;
+
+  // Pens holding the animal now; entries run in pen order within a cell
+  scratchPens.clear();
+  const SpatialGrid::Cell* cell = grid.find_cell(state.cellX, state.cellZ);
+  if (cell) {
+    for (uint32_t e = 0; e < cell->count; e++) {
+      const CellPen& cellPen = entries[grid.items()[cell->start + e]];
+      if (cellPen.boundary) {
+        state.needsTest = true;
+        polygonTests++;
+        if (!contains(shapes[cellPen.pen], pos.x, pos.z)) {
+          continue;
+        }
+      }
+      scratchPens.push_back(cellPen.pen);
+    }
+  }
+  if (scratchPens == state.pens) {
+    return;
+  }
+
+  for (uint32_t pen : state.pens) {
+    if (std::binary_search(scratchPens.begin(), scratchPens.end(), pen)) {
+      continue;
+    }
+    std::vector<AnimalHandle>& contained = pens[pen]->contained_animals;
+    auto it = std::find(contained.begin(), contained.end(), handle);
+    if (it != contained.end()) {
+      *it = contained.back();
+      contained.pop_back();
+    }
+    penEvents.push_back({pen, handle, false});
+    penChanged[pen] = true;
+  }
+  for (uint32_t pen : scratchPens) {
+    if (std::binary_search(state.pens.begin(), state.pens.end(), pen)) {
+      continue;
+    }
+    pens[pen]->contained_animals.push_back(handle);
+    penEvents.push_back({pen, handle, true});
+    penChanged[pen] = true;
+  }
+  state.pens = scratchPens;
+}
+
+void PenTracker::update(std::vector<std::unique_ptr<Pen>>& pens,
+                        const AnimalPool& animals) {
+  penEvents.clear();
+  polygonTests = 0;
+  if (pens_changed(pens)) {
+    rebuild(pens, animals);
+  }
+  penChanged.assign(pens.size(), false);
+
+  // Animals removed from the pool leave their pens
+  for (uint32_t p = 0; p < pens.size(); p++) {
+    std::vector<AnimalHandle>& contained = pens[p]->contained_animals;
+    for (size_t k = 0; k < contained.size();) {
+      if (animals.valid(contained[k])) {
+        k++;
+        continue;
+      }
+      penEvents.push_back({p, contained[k], false});
+      penChanged[p] = true;
+      contained[k] = contained.back();
+      contained.pop_back();
+    }
+  }
+
+  const uint32_t animalCount = static_cast<uint32_t>(animals.size());
+  for (uint32_t i = 0; i < animalCount; i++) {
+    const AnimalHandle handle = animals.handle_of(i);
+    if (handle.slot >= slots.size()) {
+      slots.resize(handle.slot + 1);
+    }
+    SlotState& state = slots[handle.slot];
+    if (state.generation != handle.generation) {
+      // New animal, or a recycled slot whose old pens were pruned above
+      state.generation = handle.generation;
+      state.pens.clear();
+      state.needsTest = true;
+    }
+    const vec3& pos = animals.pos[i];
+    if (!state.needsTest && grid.cell_coord(pos.x) == state.cellX &&
+        grid.cell_coord(pos.z) == state.cellZ) {
+      continue;  // Same inside/outside cell as last tick
+    }
+    update_slot(state, handle, pos, pens);
+  }
+
+  // Species only changes with membership
+  for (uint32_t p = 0; p < pens.size(); p++) {
+    if (penChanged[p]) {
+      pens[p]->updateSpecies(animals);
+    }
+  }
+}
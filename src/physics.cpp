@@ -1,193 +1,448 @@
 #include "physics.hpp"
 
-// Helper function to compute the grid cell based on position
-GridKey get_grid_key(const vec3& pos, float grid_size) {
-  return {
-      static_cast<int>(pos.x / grid_size),
-      static_cast<int>(pos.z / grid_size)  // 2D grid, ignoring z-axis
-  };
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#include "fence_index.hpp"
+#include "profiler.hpp"
+#include "simd.hpp"
+
+// Helper function to bucket every animal into the persistent grid
+void build_animal_grid(GameState& GameState) {
+  const AnimalPool& animals = *GameState.animals;
+  GameState.animalGrid.build(animals.pos.data(), animals.size());
 }
 
-// Helper function to add objects to grid cells
-void add_to_grid(Grid& grid, Animal* animal, float grid_size) {
-  GridKey key = get_grid_key(animal->pos, grid_size);
-  grid[key].push_back(animal);
+// Push two overlapping animals apart by half the overlap each
+static inline bool resolve_animal_pair(vec3& a,
+                                       float radiusA,
+                                       vec3& b,
+                                       float radiusB,
+                                       CollisionStats& stats) {
+  if (!CheckCollisionSpheres(a, radiusA, b, radiusB)) {
+    return false;
+  }
+  vec3 collisionNormal = Vector3Normalize(Vector3Subtract(b, a));
+  float overlap = radiusA + radiusB - Vector3Distance(a, b);
+  a = Vector3Subtract(a, Vector3Scale(collisionNormal, overlap * 0.5f));
+  b = Vector3Add(b, Vector3Scale(collisionNormal, overlap * 0.5f));
+  stats.maxPenetration = std::max(stats.maxPenetration, overlap);
+  return true;
 }
 
-void check_grid_collisions(const Grid& grid,
-                           const GridKey& key,
-                           const float animalRadius,
-                           GameState& GameState) {
-  static const int neighbor_offsets[3] = {
-      -1, 0, 1};  // To check neighboring cells in both x and z axes
-
-  for (int dx : neighbor_offsets) {
-    for (int dz : neighbor_offsets) {
-      GridKey neighbor_key = {key.first + dx, key.second + dz};
-
-      auto it = grid.find(neighbor_key);
-      if (it != grid.end()) {
-        const std::vector<Animal*>& nearbyAnimals = it->second;
-
-        // Player vs Animals in nearby grid cells
-        for (Animal* animal : nearbyAnimals) {
-          if (CheckCollisionSpheres(GameState.player->pos,
-                                    GameState.player->radius, animal->pos,
-                                    animalRadius)) {
-            // Handle player-animal collision
-            vec3 collisionNormal = Vector3Normalize(
-                Vector3Subtract(animal->pos, GameState.player->pos));
-            float overlap = GameState.player->radius + animalRadius -
-                            Vector3Distance(GameState.player->pos, animal->pos);
-            GameState.player->pos =
-                Vector3Subtract(GameState.player->pos,
-                                Vector3Scale(collisionNormal, overlap * 0.5f));
-            animal->pos = Vector3Add(
-                animal->pos, Vector3Scale(collisionNormal, overlap * 0.5f));
-          }
-        }
+// Raise `target` to at least `value`
+static void atomic_max(std::atomic<float>& target, float value) {
+  float current = target.load(std::memory_order_relaxed);
+  while (current < value &&
+         !target.compare_exchange_weak(current, value,
+                                       std::memory_order_relaxed)) {
+  }
+}
 
-        // Animal vs Animal within the same nearby grid cells
-        for (size_t i = 0; i < nearbyAnimals.size(); ++i) {
-          for (size_t j = i + 1; j < nearbyAnimals.size(); ++j) {
-            if (CheckCollisionSpheres(nearbyAnimals[i]->pos, animalRadius,
-                                      nearbyAnimals[j]->pos, animalRadius)) {
-              // Handle animal-animal collision
-              vec3 collisionNormal = Vector3Normalize(Vector3Subtract(
-                  nearbyAnimals[j]->pos, nearbyAnimals[i]->pos));
-              float overlap =
-                  2 * animalRadius -
-                  Vector3Distance(nearbyAnimals[i]->pos, nearbyAnimals[j]->pos);
-              nearbyAnimals[i]->pos = Vector3Subtract(
-                  nearbyAnimals[i]->pos,
-                  Vector3Scale(collisionNormal, overlap * 0.5f));
-              nearbyAnimals[j]->pos =
-                  Vector3Add(nearbyAnimals[j]->pos,
-                             Vector3Scale(collisionNormal, overlap * 0.5f));
-            }
-          }
+// Animal vs Animal for every pair that has its first animal in `cell`: pairs
+// inside the cell, then pairs with the forward half of its neighborhood. The
+// other four neighbors own the pairs they share with this cell, so each
+// unordered pair is tested exactly once. Only touches animals in cells
+// x-1..x+1, z..z+1, which is what makes the cell coloring safe.
+void check_grid_collisions(const SpatialGrid& grid,
+                           const SpatialGrid::Cell& cell,
+                           AnimalPool& animals,
+                           CollisionStats& stats) {
+  static const int forward_offsets[4][2] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1}};
+  std::vector<vec3>& pos = animals.pos;
+  const uint32_t* members = grid.items() + cell.start;
+
+  for (uint32_t i = 0; i < cell.count; ++i) {
+    const uint32_t a = members[i];
+    const float radiusA = animals.radius(a);
+    for (uint32_t j = i + 1; j < cell.count; ++j) {
+      const uint32_t b = members[j];
+      stats.pairsTested++;
+      if (resolve_animal_pair(pos[a], radiusA, pos[b], animals.radius(b),
+                              stats)) {
+        stats.contactsResolved++;
+      }
+    }
+  }
+
+  for (const auto& offset : forward_offsets) {
+    const SpatialGrid::Cell* other =
+        grid.find_cell(cell.x + offset[0], cell.z + offset[1]);
+    if (!other) {
+      continue;
+    }
+    const uint32_t* nearby = grid.items() + other->start;
+    for (uint32_t i = 0; i < cell.count; ++i) {
+      const uint32_t a = members[i];
+      const float radiusA = animals.radius(a);
+      for (uint32_t j = 0; j < other->count; ++j) {
+        const uint32_t b = nearby[j];
+        stats.pairsTested++;
+        if (resolve_animal_pair(pos[a], radiusA, pos[b], animals.radius(b),
+                                stats)) {
+          stats.contactsResolved++;
         }
       }
     }
   }
 }
 
-// Check collisions within a grid cell and its neighbors
-void handle_collisions(GameState& GameState,
-                       int& substeps,
-                       std::vector<std::unique_ptr<Pen>>& pens) {
-  const float playerRadius = 1.0f;
+void closest_points_on_segment(vec3 start,
+                               vec3 end,
+                               const float* x,
+                               const float* y,
+                               const float* z,
+                               size_t count,
+                               float* t,
+                               float* dist2) {
+  const vec3 d = Vector3Subtract(end, start);
+  const float len2 = Vector3DotProduct(d, d);
+  const float invLen2 = len2 > 0.0f ? 1.0f / len2 : 0.0f;
+
+  size_t i = 0;
+  const simd::float4 sx = simd::splat(start.x);
+  const simd::float4 sy = simd::splat(start.y);
+  const simd::float4 sz = simd::splat(start.z);
+  const simd::float4 dx = simd::splat(d.x);
+  const simd::float4 dy = simd::splat(d.y);
+  const simd::float4 dz = simd::splat(d.z);
+  const simd::float4 inv = simd::splat(invLen2);
+  const simd::float4 zero = simd::splat(0.0f);
+  const simd::float4 one = simd::splat(1.0f);
+  for (; i + 4 <= count; i += 4) {
+    simd::float4 px = simd::load(x + i) - sx;
+    simd::float4 py = simd::load(y + i) - sy;
+    simd::float4 pz = simd::load(z + i) - sz;
+    simd::float4 ti =
+        simd::min(simd::max((px * dx + py * dy + pz * dz) * inv, zero), one);
+    simd::float4 ex = px - dx * ti;
+    simd::float4 ey = py - dy * ti;
+    simd::float4 ez = pz - dz * ti;
+    simd::store(t + i, ti);
+    simd::store(dist2 + i, ex * ex + ey * ey + ez * ez);
+  }
+  for (; i < count; i++) {
+    float px = x[i] - start.x;
+    float py = y[i] - start.y;
+    float pz = z[i] - start.z;
+    float ti = Clamp((px * d.x + py * d.y + pz * d.z) * invLen2, 0.0f, 1.0f);
+    float ex = px - d.x * ti;
+    float ey = py - d.y * ti;
+    float ez = pz - d.z * ti;
+    t[i] = ti;
+    dist2[i] = ex * ex + ey * ey + ez * ez;
+  }
+}
+
+// Animals near one rope segment, gathered into SoA for the distance kernel.
+// Kept between calls so the rope pass allocates nothing in steady state.
+struct SegmentCandidates {
+  std::vector<uint32_t> index;
+  std::vector<float> x, y, z, t, dist2;
+};
+static SegmentCandidates ropeCandidates;
+
+// Rope vs Animals: each segment only looks at the grid cells its box
+// (grown by the rope radius) overlaps
+void collide_rope_with_animals(GameState& GameState) {
   const float ropeSegmentRadius = 0.7f;  // From the Rope constructor
+  const SpatialGrid& grid = GameState.animalGrid;
+  AnimalPool& animals = *GameState.animals;
+  Rope& rope = GameState.player->rope;
+  SegmentCandidates& candidates = ropeCandidates;
 
-  // Player cube vs Animals
-  for (int i = 0; i < substeps; i++) {
-    Grid grid;
+  for (int i = 0; i < rope.num_points - 1; i++) {
+    const vec3 start = rope.point(i);
+    const vec3 end = rope.point(i + 1);
+    const int minX =
+        grid.cell_coord(std::min(start.x, end.x) - ropeSegmentRadius);
+    const int maxX =
+        grid.cell_coord(std::max(start.x, end.x) + ropeSegmentRadius);
+    const int minZ =
+        grid.cell_coord(std::min(start.z, end.z) - ropeSegmentRadius);
+    const int maxZ =
+        grid.cell_coord(std::max(start.z, end.z) + ropeSegmentRadius);
 
-    for (auto& animal : GameState.animals) {
-      add_to_grid(grid, animal.get(), GRID_SIZE);
+    candidates.index.clear();
+    candidates.x.clear();
+    candidates.y.clear();
+    candidates.z.clear();
+    for (int cellX = minX; cellX <= maxX; cellX++) {
+      for (int cellZ = minZ; cellZ <= maxZ; cellZ++) {
+        const SpatialGrid::Cell* cell = grid.find_cell(cellX, cellZ);
+        if (!cell) {
+          continue;
+        }
+        const uint32_t* members = grid.items() + cell->start;
+        for (uint32_t m = 0; m < cell->count; m++) {
+          const vec3& animalPos = animals.pos[members[m]];
+          candidates.index.push_back(members[m]);
+          candidates.x.push_back(animalPos.x);
+          candidates.y.push_back(animalPos.y);
+          candidates.z.push_back(animalPos.z);
+        }
+      }
+    }
+    const size_t count = candidates.index.size();
+    if (count == 0) {
+      continue;
     }
+    candidates.t.resize(count);
+    candidates.dist2.resize(count);
+    closest_points_on_segment(start, end, candidates.x.data(),
+                              candidates.y.data(), candidates.z.data(), count,
+                              candidates.t.data(), candidates.dist2.data());
 
-    // Step 2: Perform collision detection using grid
-    for (auto& animal : GameState.animals) {
-      GridKey key = get_grid_key(animal->pos, GRID_SIZE);
-      check_grid_collisions(grid, key, animal->species.radius, GameState);
+    const vec3 segment = Vector3Subtract(end, start);
+    for (size_t c = 0; c < count; c++) {
+      if (candidates.dist2[c] > ropeSegmentRadius * ropeSegmentRadius) {
+        continue;
+      }
+      // Handle rope-animal collision
+      const uint32_t a = candidates.index[c];
+      vec3 closestPoint =
+          Vector3Add(start, Vector3Scale(segment, candidates.t[c]));
+      vec3 collisionNormal =
+          Vector3Normalize(Vector3Subtract(animals.pos[a], closestPoint));
+      float overlap = ropeSegmentRadius + animals.radius(a) -
+                      std::sqrt(candidates.dist2[c]);
+      animals.targ[a] = Vector3Add(
+          animals.targ[a], Vector3Scale(collisionNormal, overlap * 0.8));
+
+      // Displace rope points
+      vec3 displacementVector = Vector3Scale(collisionNormal, -overlap * 0.2f);
+      rope.system->displace(rope.id, i, displacementVector);
+      rope.system->displace(rope.id, i + 1, displacementVector);
     }
+  }
+}
 
-    // rope and animals
-    if (!IsKeyDown(KEY_LEFT_SHIFT)) {
-      for (auto& animal : GameState.animals) {
-        for (int i = 0; i < GameState.player->rope.num_points - 1; i++) {
-          if (CheckCollisionPointLine(
-                  animal->pos, GameState.player->rope.points[i],
-                  GameState.player->rope.points[i + 1], ropeSegmentRadius)) {
-            // Handle rope-animal collision
-            vec3 closestPoint = GetClosestPointOnLineFromPoint(
-                animal->pos, GameState.player->rope.points[i],
-                GameState.player->rope.points[i + 1]);
-            vec3 collisionNormal =
-                Vector3Normalize(Vector3Subtract(animal->pos, closestPoint));
-            float overlap = ropeSegmentRadius + animal->species.radius -
-                            Vector3Distance(closestPoint, animal->pos);
-            animal->targ = Vector3Add(
-                animal->targ, Vector3Scale(collisionNormal, overlap * 0.8));
-
-            // Displace rope points
-            vec3 displacementVector =
-                Vector3Scale(collisionNormal, overlap * 0.2f);
-            GameState.player->rope.points[i] = Vector3Subtract(
-                GameState.player->rope.points[i], displacementVector);
-            GameState.player->rope.points[i + 1] = Vector3Subtract(
-                GameState.player->rope.points[i + 1], displacementVector);
-          }
+// Pens vs Animals: each animal only tests the fence segments and posts
+// indexed in its own cell, skipping pens whose box it is outside of
+void collide_pens_with_animals(GameState& GameState) {
+  const float ropeSegmentRadius = 0.7f;  // From the Rope constructor
+  FenceIndex& index = *GameState.fenceIndex;
+  index.refit(GameState.pens);
+  if (index.empty()) {
+    return;
+  }
+  AnimalPool& animals = *GameState.animals;
+  const uint32_t animalCount = static_cast<uint32_t>(animals.size());
+
+  for (uint32_t a = 0; a < animalCount; a++) {
+    vec3& animalPos = animals.pos[a];
+    const float animalRadius = animals.radius(a);
+    const SpatialGrid::Cell* cell = index.find(animalPos.x, animalPos.z);
+    if (!cell) {
+      continue;
+    }
+
+    uint32_t currentPen = UINT32_MAX;
+    bool penInReach = false;
+    for (uint32_t e = 0; e < cell->count; e++) {
+      const FenceIndex::Feature& feature = index.feature(*cell, e);
+      if (feature.pen != currentPen) {
+        currentPen = feature.pen;
+        const AABB& bounds = index.pen_bounds(currentPen);
+        penInReach = animalPos.x >= bounds.min.x &&
+                     animalPos.x <= bounds.max.x &&
+                     animalPos.z >= bounds.min.z && animalPos.z <= bounds.max.z;
+      }
+      if (!penInReach) {
+        continue;
+      }
+      Pen& pen = *GameState.pens[feature.pen];
+
+      if (feature.post) {
+        const vec3& post = pen.fixed_points[feature.point];
+        if (CheckCollisionSpheres(animalPos, animalRadius, post, 1.0)) {
+          vec3 collisionNormal =
+              Vector3Normalize(Vector3Subtract(animalPos, post));
+          float overlap =
+              animalRadius + 1.0 - Vector3Distance(animalPos, post);
+          animalPos =
+              Vector3Add(animalPos, Vector3Scale(collisionNormal, overlap));
         }
+        continue;
       }
-    }
 
-    // pens and animals
-    for (auto& animal : GameState.animals) {
-      for (auto& pen : GameState.pens) {
-        for (size_t i = 0; i < pen->rope_points.size(); ++i) {
-          for (size_t j = 0; j < pen->rope_points[i].size() - 1; ++j) {
-            vec3 start = pen->rope_points[i][j];
-            vec3 end = pen->rope_points[i][j + 1];
-
-            // if (CheckCollisionPointLine(animal->pos, start, end,
-            // ropeSegmentRadius)) {
-            if (CheckCollisionSpheres(animal->pos, animal->species.radius,
-                                      start, 0.05)) {
-              vec3 closestPoint =
-                  GetClosestPointOnLineFromPoint(animal->pos, start, end);
-              vec3 collisionNormal =
-                  Vector3Normalize(Vector3Subtract(animal->pos, closestPoint));
-              float overlap = ropeSegmentRadius + animal->species.radius -
-                              Vector3Distance(closestPoint, animal->pos);
-
-              // Update animal target position
-              animal->targ = Vector3Add(
-                  animal->targ, Vector3Scale(collisionNormal, overlap * 0.8f));
-
-              // Displace rope points (except fixed points)
-              vec3 displacementVector =
-                  Vector3Scale(collisionNormal, overlap * 0.2f);
-              if (j > 0) {
-                pen->rope_points[i][j] =
-                    Vector3Subtract(pen->rope_points[i][j], displacementVector);
-              }
-              if (j < pen->rope_points[i].size() - 2) {
-                pen->rope_points[i][j + 1] = Vector3Subtract(
-                    pen->rope_points[i][j + 1], displacementVector);
-              }
-            }
-          }
+      RopeSystem& ropes = *pen.ropes;
+      const RopeId edge = pen.edges[feature.edge];
+      const uint32_t j = feature.point;
+      vec3 start = ropes.point(edge, j);
+      vec3 end = ropes.point(edge, j + 1);
+      if (CheckCollisionSpheres(animalPos, animalRadius, start, 0.05)) {
+        vec3 closestPoint =
+            GetClosestPointOnLineFromPoint(animalPos, start, end);
+        vec3 collisionNormal =
+            Vector3Normalize(Vector3Subtract(animalPos, closestPoint));
+        float overlap = ropeSegmentRadius + animalRadius -
+                        Vector3Distance(closestPoint, animalPos);
+
+        // Update animal target position
+        animals.targ[a] = Vector3Add(
+            animals.targ[a], Vector3Scale(collisionNormal, overlap * 0.8f));
+
+        // Displace rope points (except fixed points)
+        vec3 displacementVector =
+            Vector3Scale(collisionNormal, -overlap * 0.2f);
+        if (j > 0) {
+          ropes.displace(edge, j, displacementVector);
         }
-        for (size_t i = 0; i < pen->fixed_points.size(); ++i) {
-          if (CheckCollisionSpheres(animal->pos, animal->species.radius,
-                                    pen->fixed_points[i], 1.0)) {
-            vec3 collisionNormal = Vector3Normalize(
-                Vector3Subtract(animal->pos, pen->fixed_points[i]));
-            float overlap = animal->species.radius + 1.0 -
-                            Vector3Distance(animal->pos, pen->fixed_points[i]);
-            animal->pos =
-                Vector3Add(animal->pos, Vector3Scale(collisionNormal, overlap));
-          }
+        if (j + 2 < ropes.count(edge)) {
+          ropes.displace(edge, j + 1, displacementVector);
         }
       }
     }
+  }
+}
+
+// Split the occupied cells into 9 classes by (x mod 3, z mod 3), keeping the
+// grid's own cell order inside each class
+void assign_cell_colors(GameState& GameState) {
+  for (auto& color : GameState.cellColors) {
+    color.clear();
+  }
+  const std::vector<SpatialGrid::Cell>& cells = GameState.animalGrid.cells();
+  for (uint32_t c = 0; c < cells.size(); c++) {
+    int colorX = ((cells[c].x % 3) + 3) % 3;
+    int colorZ = ((cells[c].z % 3) + 3) % 3;
+    GameState.cellColors[colorX * 3 + colorZ].push_back(c);
+  }
+}
+
+// Player vs Animals in the cells around the player; serial, since every
+// contact moves the player
+void collide_player_with_animals(GameState& GameState,
+                                 CollisionStats& stats) {
+  const SpatialGrid& grid = GameState.animalGrid;
+  AnimalPool& animals = *GameState.animals;
+  Player& player = *GameState.player;
+  const int cellX = grid.cell_coord(player.pos.x);
+  const int cellZ = grid.cell_coord(player.pos.z);
+
+  for (int dx = -1; dx <= 1; dx++) {
+    for (int dz = -1; dz <= 1; dz++) {
+      const SpatialGrid::Cell* cell = grid.find_cell(cellX + dx, cellZ + dz);
+      if (!cell) {
+        continue;
+      }
+      const uint32_t* nearby = grid.items() + cell->start;
+      for (uint32_t n = 0; n < cell->count; ++n) {
+        vec3& animalPos = animals.pos[nearby[n]];
+        const float animalRadius = animals.radius(nearby[n]);
+        stats.pairsTested++;
+        if (CheckCollisionSpheres(player.pos, player.radius, animalPos,
+                                  animalRadius)) {
+          stats.contactsResolved++;
+          vec3 collisionNormal =
+              Vector3Normalize(Vector3Subtract(animalPos, player.pos));
+          float overlap = player.radius + animalRadius -
+                          Vector3Distance(player.pos, animalPos);
+          player.pos = Vector3Subtract(
+              player.pos, Vector3Scale(collisionNormal, overlap * 0.5f));
+          animalPos = Vector3Add(animalPos,
+                                 Vector3Scale(collisionNormal, overlap * 0.5f));
+        }
+      }
+    }
+  }
+}
+
+// Check collisions within a grid cell and its neighbors
+void handle_collisions(GameState& GameState,
+                       const SimInput& input,
+                       int substeps) {
+  PROFILE_SCOPE("Collisions");
+  AnimalPool& animals = *GameState.animals;
+  const uint32_t animalCount = static_cast<uint32_t>(animals.size());
+  JobSystem& jobs = *GameState.jobs;
+  CollisionStats total;
+
+  for (int i = 0; i < substeps; i++) {
+    {
+      PROFILE_SCOPE("Build grid");
+      build_animal_grid(GameState);
+      assign_cell_colors(GameState);
+    }
+    const SpatialGrid& grid = GameState.animalGrid;
+    const std::vector<SpatialGrid::Cell>& cells = grid.cells();
+
+    {
+      PROFILE_SCOPE("Player vs animals");
+      collide_player_with_animals(GameState, total);
+    }
 
-    // Player tether vs Animals
-    for (auto& animal : GameState.animals) {
-      if (CheckCollisionSpheres(GameState.player->tether.pos,
-                                GameState.player->tether.radius, animal->pos,
-                                animal->species.radius)) {
-        // Handle tether-animal collision
-        vec3 collisionNormal = Vector3Normalize(
-            Vector3Subtract(animal->pos, GameState.player->tether.pos));
-        float overlap =
-            GameState.player->tether.radius + animal->species.radius -
-            Vector3Distance(GameState.player->tether.pos, animal->pos);
-        animal->pos =
-            Vector3Add(animal->pos, Vector3Scale(collisionNormal, overlap));
+    // Animal vs Animal, one color at a time. Same-colored cells are 3 apart,
+    // so jobs within a color never share an animal and every animal sees the
+    // same sequence of updates whatever the thread count.
+    std::atomic<uint64_t> pairsTested{0};
+    std::atomic<uint64_t> contactsResolved{0};
+    std::atomic<float> maxPenetration{0.0f};
+    {
+      PROFILE_SCOPE("Animal vs animal");
+      for (const std::vector<uint32_t>& color : GameState.cellColors) {
+        jobs.parallel_for(color.size(), 8, [&](size_t begin, size_t end) {
+          CollisionStats stats;
+          for (size_t c = begin; c < end; c++) {
+            check_grid_collisions(grid, cells[color[c]], animals, stats);
+          }
+          pairsTested += stats.pairsTested;
+          contactsResolved += stats.contactsResolved;
+          atomic_max(maxPenetration, stats.maxPenetration);
+        });
       }
     }
+    total.pairsTested += pairsTested;
+    total.contactsResolved += contactsResolved;
+    // Only the last substep counts: it is what the earlier ones left behind
+    total.maxPenetration = maxPenetration;
+
+    // rope and animals
+    if (!input.ropeSlack) {
+      PROFILE_SCOPE("Rope vs animals");
+      collide_rope_with_animals(GameState);
+    }
+
+    // pens and animals
+    {
+      PROFILE_SCOPE("Pens vs animals");
+      collide_pens_with_animals(GameState);
+    }
+
+    // Player tether vs Animals; each animal only moves itself
+    PROFILE_SCOPE("Tether vs animals");
+    const Tether& tether = GameState.player->tether;
+    jobs.parallel_for(animalCount, 1024, [&](size_t begin, size_t end) {
+      for (size_t a = begin; a < end; a++) {
+        vec3& animalPos = animals.pos[a];
+        const float animalRadius = animals.radius(a);
+        if (CheckCollisionSpheres(tether.pos, tether.radius, animalPos,
+                                  animalRadius)) {
+          // Handle tether-animal collision
+          vec3 collisionNormal =
+              Vector3Normalize(Vector3Subtract(animalPos, tether.pos));
+          float overlap = tether.radius + animalRadius -
+                          Vector3Distance(tether.pos, animalPos);
+          animalPos =
+              Vector3Add(animalPos, Vector3Scale(collisionNormal, overlap));
+        }
+      }
+    });
+  }
+  GameState.collisionStats = total;
+}
+
+int adapt_substeps(const CollisionStats& stats, int substeps) {
+  if (stats.contactsResolved == 0) {
+    return MIN_SUBSTEPS;
+  }
+  if (stats.maxPenetration > PENETRATION_HIGH) {
+    return std::min(substeps + 1, MAX_SUBSTEPS);
+  }
+  if (stats.maxPenetration < PENETRATION_LOW) {
+    return std::max(substeps - 1, MIN_SUBSTEPS);
   }
+  return substeps;
 }
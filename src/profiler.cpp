@@ -0,0 +1,231 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+
+namespace Profiler {
+namespace {
+
+// Fields are atomics so a reader copying a slot while its thread rewrites
+// it is well defined; relaxed stores cost the same as plain ones.
+struct Slot {
+  std::atomic<const char*> name{nullptr};
+  std::atomic<uint64_t> start{0};
+  std::atomic<uint64_t> packed{0};  // duration | depth << 32
+};
+
+// Single-writer ring: only the owning thread pushes, and it publishes each
+// event by bumping head with release order after filling the slot
+struct Ring {
+  std::unique_ptr<Slot[]> slots{new Slot[RING_CAPACITY]};
+  std::atomic<uint64_t> head{0};  // Events ever pushed
+  uint32_t id = 0;
+  std::string name;    // Guarded by Registry::mutex
+  bool inUse = false;  // Guarded by Registry::mutex
+
+  void push(const char* eventName,
+            uint64_t start,
+            uint32_t duration,
+            uint32_t depth) {
+    uint64_t h = head.load(std::memory_order_relaxed);
+    Slot& slot = slots[h & (RING_CAPACITY - 1)];
+    slot.name.store(eventName, std::memory_order_relaxed);
+    slot.start.store(start, std::memory_order_relaxed);
+    slot.packed.store(duration | static_cast<uint64_t>(depth) << 32,
+                      std::memory_order_relaxed);
+    head.store(h + 1, std::memory_order_release);
+  }
+
+  Event read(uint64_t index) const {
+    const Slot& slot = slots[index & (RING_CAPACITY - 1)];
+    uint64_t packed = slot.packed.load(std::memory_order_relaxed);
+    return Event{slot.name.load(std::memory_order_relaxed),
+                 slot.start.load(std::memory_order_relaxed),
+                 static_cast<uint32_t>(packed),
+                 static_cast<uint32_t>(packed >> 32)};
+  }
+};
+
+// Rings outlive their threads: a finished thread's ring passes to the next
+// new one, so pools that come and go (headless sweeps, benchmarks) do not
+// grow the registry. Never destroyed, since threads may still be exiting
+// during static destruction.
+struct Registry {
+  std::mutex mutex;
+  std::vector<std::unique_ptr<Ring>> rings;
+};
+
+Registry& registry() {
+  static Registry* instance = new Registry;
+  return *instance;
+}
+
+Ring* acquire_ring() {
+  Registry& reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mutex);
+  for (auto& ring : reg.rings) {
+    if (!ring->inUse) {
+      ring->inUse = true;
+      ring->name = "Thread " + std::to_string(ring->id);
+      return ring.get();
+    }
+  }
+  reg.rings.push_back(std::make_unique<Ring>());
+  Ring* ring = reg.rings.back().get();
+  ring->id = static_cast<uint32_t>(reg.rings.size());
+  ring->name = "Thread " + std::to_string(ring->id);
+  ring->inUse = true;
+  return ring;
+}
+
+struct ThreadState {
+  Ring* ring = nullptr;
+  uint32_t depth = 0;
+
+  ~ThreadState() {
+    if (ring) {
+      std::lock_guard<std::mutex> lock(registry().mutex);
+      ring->inUse = false;
+    }
+  }
+
+  Ring& get() {
+    if (!ring) {
+      ring = acquire_ring();
+    }
+    return *ring;
+  }
+};
+
+thread_local ThreadState threadState;
+
+// Copy the events of `ring` ending after `since`, dropping any that the
+// owner overwrote while we read
+std::vector<Event> copy_ring(const Ring& ring, uint64_t since) {
+  uint64_t head = ring.head.load(std::memory_order_acquire);
+  uint64_t first = head > RING_CAPACITY ? head - RING_CAPACITY : 0;
+  std::vector<Event> events;
+  events.reserve(head - first);
+  for (uint64_t i = first; i < head; i++) {
+    events.push_back(ring.read(i));
+  }
+  uint64_t after = ring.head.load(std::memory_order_acquire);
+  uint64_t valid = after > RING_CAPACITY ? after - RING_CAPACITY : 0;
+  if (valid > first) {
+    events.erase(events.begin(),
+                 events.begin() + std::min<uint64_t>(valid - first,
+                                                     events.size()));
+  }
+  events.erase(std::remove_if(events.begin(), events.end(),
+                              [&](const Event& e) {
+                                return e.start + e.duration < since;
+                              }),
+               events.end());
+  return events;
+}
+
+}  // namespace
+
+uint64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void set_thread_name(const char* name) {
+  Ring& ring = threadState.get();
+  std::lock_guard<std::mutex> lock(registry().mutex);
+  ring.name = name;
+}
+
+Scope::Scope(const char* name) : name(name), start(now_ns()) {
+  threadState.depth++;
+}
+
+Scope::~Scope() {
+  uint64_t duration = now_ns() - start;
+  threadState.depth--;
+  threadState.get().push(
+      name, start, static_cast<uint32_t>(std::min<uint64_t>(duration, ~0u)),
+      threadState.depth);
+}
+
+std::vector<ThreadEvents> collect(uint64_t since) {
+  Registry& reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mutex);
+  std::vector<ThreadEvents> threads;
+  for (const auto& ring : reg.rings) {
+    ThreadEvents thread{ring->name, ring->id, copy_ring(*ring, since)};
+    if (!thread.events.empty()) {
+      threads.push_back(std::move(thread));
+    }
+  }
+  return threads;
+}
+
+std::vector<Event> last_frame() {
+  // Only this thread writes its ring, so it can be read without care
+  const Ring& ring = threadState.get();
+  uint64_t head = ring.head.load(std::memory_order_relaxed);
+  uint64_t first = head > RING_CAPACITY ? head - RING_CAPACITY : 0;
+  std::vector<Event> frame;
+  uint64_t i = head;
+  while (i > first) {
+    Event event = ring.read(--i);
+    if (event.depth == 0) {
+      frame.push_back(event);
+      break;
+    }
+  }
+  if (frame.empty()) {
+    return frame;
+  }
+  // Nested scopes end, and so are pushed, before the scope around them
+  const uint64_t frameStart = frame[0].start;
+  while (i > first) {
+    Event event = ring.read(--i);
+    if (event.depth == 0 || event.start < frameStart) {
+      break;
+    }
+    frame.push_back(event);
+  }
+  std::reverse(frame.begin(), frame.end());
+  return frame;
+}
+
+bool write_chrome_trace(const std::string& path, double seconds) {
+  const uint64_t now = now_ns();
+  const uint64_t window = static_cast<uint64_t>(seconds * 1e9);
+  const uint64_t since = now > window ? now - window : 0;
+  std::vector<ThreadEvents> threads = collect(since);
+
+  FILE* file = fopen(path.c_str(), "w");
+  if (!file) {
+    return false;
+  }
+  // Complete ("X") events in microseconds from the start of the window
+  fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+  bool first = true;
+  for (const ThreadEvents& thread : threads) {
+    fprintf(file,
+            "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, "
+            "\"tid\": %u, \"args\": {\"name\": \"%s\"}}",
+            first ? "" : ",\n", thread.id, thread.name.c_str());
+    first = false;
+    for (const Event& event : thread.events) {
+      double start = event.start > since ? (event.start - since) * 1e-3 : 0.0;
+      fprintf(file,
+              ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, "
+              "\"ts\": %.3f, \"dur\": %.3f}",
+              event.name, thread.id, start, event.duration * 1e-3);
+    }
+  }
+  fprintf(file, "\n]}\n");
+  return fclose(file) == 0;
+}
+
+}  // namespace Profiler
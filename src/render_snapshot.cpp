@@ -0,0 +1,87 @@
+#include "render_snapshot.hpp"
+
+#include "animal.hpp"
+#include "buildings.hpp"
+#include "collectables.hpp"
+#include "player.hpp"
+#include "rope_system.hpp"
+
+static void copy_rope_points(const RopeSystem& ropes,
+                             std::vector<vec3>& points) {
+  points.resize(ropes.particle_count());
+  for (size_t i = 0; i < ropes.particle_count(); i++) {
+    points[i] = vec3(ropes.xs()[i], ropes.ys()[i], ropes.zs()[i]);
+  }
+}
+
+void save_tick(const GameState& GameState, TickHistory& history) {
+  history.animalPos = GameState.animals->pos;
+  copy_rope_points(*GameState.ropes, history.ropePoints);
+  history.tetherPos = GameState.player->tether.pos;
+  history.playerTransform = GameState.player->transform;
+  history.camera = GameState.camera;
+}
+
+static RopeTube rope_tube(const RopeSystem& ropes,
+                          RopeId rope,
+                          float radius,
+                          int sides,
+                          Color color) {
+  return RopeTube{ropes.particle_index(rope, 0), ropes.count(rope), radius,
+                  sides, color};
+}
+
+void capture_render_snapshot(const GameState& GameState,
+                             const TickHistory& history,
+                             RenderSnapshot& snapshot) {
+  snapshot.tick = GameState.tick;
+  snapshot.previous = history;
+
+  const AnimalPool& animals = *GameState.animals;
+  snapshot.animalPos = animals.pos;
+  snapshot.animalRadius.resize(animals.size());
+  snapshot.animalColor.resize(animals.size());
+  for (uint32_t i = 0; i < animals.size(); i++) {
+    const Species& species = species_info(animals.species[i]);
+    snapshot.animalRadius[i] = species.radius;
+    snapshot.animalColor[i] = species.color;
+  }
+
+  const RopeSystem& ropes = *GameState.ropes;
+  copy_rope_points(ropes, snapshot.ropePoints);
+  const Rope& rope = GameState.player->rope;
+  snapshot.playerRope =
+      rope_tube(ropes, rope.id, rope.thickness, rope.sides, rope.color);
+
+  snapshot.penEdges.clear();
+  snapshot.posts.clear();
+  snapshot.pens.clear();
+  for (const auto& pen : GameState.pens) {
+    PenView view;
+    view.firstEdge = static_cast<uint32_t>(snapshot.penEdges.size());
+    view.edgeCount = static_cast<uint32_t>(pen->edges.size());
+    view.firstPost = static_cast<uint32_t>(snapshot.posts.size());
+    view.postCount = static_cast<uint32_t>(pen->fixed_points.size());
+    for (RopeId edge : pen->edges) {
+      snapshot.penEdges.push_back(rope_tube(ropes, edge, pen->thickness,
+                                            pen->sides, pen->species.color));
+    }
+    snapshot.posts.insert(snapshot.posts.end(), pen->fixed_points.begin(),
+                          pen->fixed_points.end());
+    snapshot.pens.push_back(view);
+  }
+
+  const Player& player = *GameState.player;
+  snapshot.tetherPos = player.tether.pos;
+  snapshot.tetherRadius = player.tether.radius;
+  snapshot.playerTransform = player.transform;
+
+  const CoinPool& coins = *GameState.coinPool;
+  snapshot.coinPos = coins.pos;
+  snapshot.coinRadius = coins.radius;
+
+  snapshot.fencePoints = GameState.fence->points;
+  snapshot.fenceJoinDist = GameState.fence->joinDist;
+  snapshot.camera = GameState.camera;
+  snapshot.coins = GameState.coins;
+}
@@ -1,7 +1,10 @@
 #include "render_utils.hpp"
 
+#include <algorithm>
 #include <string>
 
+#include "frustum.hpp"
+#include "profiler.hpp"
 #include "raygui.h"
 
 namespace RenderUtils {
@@ -76,7 +79,7 @@ void UnloadShadowmapRenderTexture(RenderTexture2D target) {
   }
 }
 
-void update_camera(GameState& GameState) {
+void update_camera(GameState& GameState, const SimInput& input) {
   float fov_ext = 70.0;
   float fov_rest = 60.0;
   GameState.camera.target.x =
@@ -89,206 +92,588 @@ void update_camera(GameState& GameState) {
   GameState.camera.position = GameState.player->pos + CAMERA_OFFSET;
   GameState.camera.position.x = GameState.player->com.x + CAMERA_OFFSET.x;
   if (GameState.itemActive == 0) {
-    if (IsMouseButtonDown(MOUSE_BUTTON_LEFT) &&
-        GameState.camera.fovy < fov_ext) {
+    if (input.mouseLeft && GameState.camera.fovy < fov_ext) {
       GameState.camera.fovy = lerp_to(GameState.camera.fovy, fov_ext, 0.1f);
-    } else if (!IsMouseButtonDown(MOUSE_BUTTON_LEFT) &&
-               GameState.camera.fovy > fov_rest) {
+    } else if (!input.mouseLeft && GameState.camera.fovy > fov_rest) {
       GameState.camera.fovy = lerp_to(GameState.camera.fovy, fov_rest, 0.1f);
     }
   }
 
-#if defined(_WIN32) || defined(_WIN64)
-  GameState.camera.fovy -= 3 * GetMouseWheelMove();
-#else
-  GameState.camera.fovy -= GetMouseWheelMove();
-#endif
+  GameState.camera.fovy -= input.zoom;
   GameState.camera.fovy = Clamp(GameState.camera.fovy, 20.0f, 100.0f);
   GameState.camera.fovy = Clamp(GameState.camera.fovy, 20.0f, 100.0f);
 }
 
-bool is_in_camera_view(const Vector3& position,
-                       float radius,
-                       const Camera& camera,
-                       int screenWidth,
-                       int screenHeight) {
-  // Convert world position to screen space
-  Vector2 screenPos = GetWorldToScreen(position, camera);
+// Light and shadow uniforms shared by every lit shader. The constant ones
+// are sent here; the rest are set each frame by update_uniforms.
+static LitProgram SetupLighting(Shader shader, const vec3& lightDir) {
+  LitProgram lit;
+  ShaderProgram& program = lit.program;
+  program = ShaderProgram(shader);
+  lit.viewPos = program.uniform("viewPos");
+  lit.lightDir = program.uniform("lightDir");
+  lit.lightVP = program.uniform("lightVP");
+  program.set(lit.lightDir, lightDir);
+  program.set(program.uniform("lightColor"), ColorNormalize(WHITE));
+  program.set(program.uniform("ambient"),
+              Vector4{0.1f, 0.1f, 0.1f, 1.0f});
+  program.set(program.uniform("shadowMap"), SHADOW_MAP_SLOT);
+  program.set(program.uniform("shadowMapResolution"), SHADOWMAP_RESOLUTION);
+  program.flush();
+  return lit;
+}
+
+SceneAssets LoadSceneAssets(Shader shadowShader, const vec3& lightDir) {
+  SceneAssets assets;
+  assets.playerModel = LoadModel("resources/models/character.glb");
+  assets.playerModel.materials[0].shader = shadowShader;
+  assets.terrain = std::make_unique<Terrain>(shadowShader);
+
+  assets.lit = SetupLighting(shadowShader, lightDir);
+  assets.instancedShader = SetupInstancedShader();
+  assets.instancedLit = SetupLighting(assets.instancedShader, lightDir);
+  assets.instanceColorLoc =
+      GetShaderLocationAttrib(assets.instancedShader, "instanceColor");
+  assets.instancedMaterial = LoadMaterialDefault();
+  assets.instancedMaterial.shader = assets.instancedShader;
+  // Unit shapes, scaled per instance
+  assets.sphereMesh = GenMeshSphere(1.0f, 20, 20);
+  assets.postMesh = GenMeshCylinder(1.0f, 1.0f, 8);
+  assets.shadowSphereMesh =
+      GenMeshSphere(1.0f, SHADOW_SPHERE_RINGS, SHADOW_SPHERE_RINGS);
+  return assets;
+}
+
+void draw_player(const Matrix& transform, Model& model) {
+  // Draw the cube with WHITE as base color (shader will modify it)
+  model.transform = transform;
+  DrawModel(model, Vector3Zero(), 1.0f, GRAY);
+  // DrawModelEx(model, Vector3Zero(), vec3(0.0, 1.0, 0.0), 0.0,
+  //            vec3(1.0, 1.0, 1.0), GRAY);
+}
+
+// A rope's particles sit side by side in the raw arrays
+void add_rope(const RopeTube& rope,
+              const std::vector<vec3>& points,
+              TubeBatch& tubes) {
+  tubes.add(&points[rope.first], rope.count, rope.radius, rope.sides,
+            rope.color);
+}
+
+// Helper function to place a unit sphere
+static Matrix sphere_transform(const vec3& pos, float radius) {
+  return MatrixMultiply(MatrixScale(radius, radius, radius),
+                        MatrixTranslate(pos.x, pos.y, pos.z));
+}
+
+// Sphere around a pen's posts and ropes, from the ground up
+static void add_pen_bounds(const RenderSnapshot& snapshot,
+                           const PenView& pen,
+                           const std::vector<vec3>& points,
+                           SphereArray& bounds) {
+  const vec3* posts = &snapshot.posts[pen.firstPost];
+  vec3 min = posts[0];
+  vec3 max = posts[0];
+  auto grow = [&](vec3 point) {
+    min = Vector3Min(min, point);
+    max = Vector3Max(max, point);
+  };
+  for (uint32_t i = 0; i < pen.postCount; i++) {
+    grow(posts[i]);
+  }
+  float thickness = 0.0f;
+  for (uint32_t e = 0; e < pen.edgeCount; e++) {
+    const RopeTube& edge = snapshot.penEdges[pen.firstEdge + e];
+    for (uint32_t i = 0; i < edge.count; i++) {
+      grow(points[edge.first + i]);
+    }
+    thickness = std::max(thickness, edge.radius);
+  }
+  min.y = std::min(min.y, 0.0f);
+  bounds.add(Vector3Scale(Vector3Add(min, max), 0.5f),
+             Vector3Distance(min, max) * 0.5f + thickness);
+}
+
+// Element i of `previous` blended toward `current`; anything that did not
+// exist a tick ago is drawn where it is now
+static vec3 blend_at(const std::vector<vec3>& previous,
+                     size_t i,
+                     vec3 current,
+                     float alpha) {
+  if (i >= previous.size()) {
+    return current;
+  }
+  return Vector3Lerp(previous[i], current, alpha);
+}
+
+Camera3D blend_camera(const TickHistory& history,
+                      const Camera3D& camera,
+                      float alpha) {
+  Camera3D view = camera;
+  view.position = Vector3Lerp(history.camera.position, camera.position, alpha);
+  view.target = Vector3Lerp(history.camera.target, camera.target, alpha);
+  view.fovy = Lerp(history.camera.fovy, camera.fovy, alpha);
+  return view;
+}
+
+void collect_instances(FrameState& frame, SceneAssets& assets) {
+  PROFILE_SCOPE("Collect instances");
+  const RenderSnapshot& snapshot = *frame.snapshot;
+  const TickHistory& history = snapshot.previous;
+  const float alpha = frame.alpha;
+  InstanceBatch& spheres = assets.spheres;
+  InstanceBatch& posts = assets.posts;
+  InstanceBatch& casters = assets.shadowSpheres;
+  spheres.clear();
+  posts.clear();
+  casters.clear();
+  assets.ropeTubes.clear();
+  assets.fenceTubes.clear();
+  assets.shadowRopeTubes.clear();
+  // Planes for the camera the main pass will use and for the light; the
+  // shadow map is square
+  const Frustum eye = Frustum::from_camera(
+      frame.view, static_cast<float>(frame.screenWidth) / frame.screenHeight);
+  const Frustum light = Frustum::from_camera(frame.lightCam, 1.0f);
+  SphereArray& bounds = assets.bounds;
+  std::vector<uint32_t>& visible = assets.visible;
+
+  // Only the translation moves between ticks; the pose is the latest one
+  Matrix& player = assets.playerTransform;
+  player = snapshot.playerTransform;
+  player.m12 = Lerp(history.playerTransform.m12, player.m12, alpha);
+  player.m13 = Lerp(history.playerTransform.m13, player.m13, alpha);
+  player.m14 = Lerp(history.playerTransform.m14, player.m14, alpha);
+
+  assets.ropePoints.resize(snapshot.ropePoints.size());
+  for (size_t i = 0; i < snapshot.ropePoints.size(); i++) {
+    assets.ropePoints[i] =
+        blend_at(history.ropePoints, i, snapshot.ropePoints[i], alpha);
+  }
+
+  const Matrix tetherTransform = sphere_transform(
+      Vector3Lerp(history.tetherPos, snapshot.tetherPos, alpha),
+      snapshot.tetherRadius);
+  spheres.add(tetherTransform, GRAY);
+  casters.add(tetherTransform, GRAY);
+
+  bounds.clear();
+  for (uint32_t i = 0; i < snapshot.animalPos.size(); i++) {
+    bounds.add(blend_at(history.animalPos, i, snapshot.animalPos[i], alpha),
+               snapshot.animalRadius[i]);
+  }
+  auto add_animals = [&](InstanceBatch& batch) {
+    for (uint32_t i : visible) {
+      vec3 pos(bounds.x[i], bounds.y[i], bounds.z[i]);
+      batch.add(sphere_transform(pos, bounds.radius[i]),
+                snapshot.animalColor[i]);
+    }
+  };
+  eye.cull_spheres(bounds, visible);
+  add_animals(spheres);
+  light.cull_spheres(bounds, visible);
+  add_animals(casters);
+
+  bounds.clear();
+  for (const vec3& coin : snapshot.coinPos) {
+    bounds.add(coin, snapshot.coinRadius);
+  }
+  eye.cull_spheres(bounds, visible);
+  for (uint32_t i : visible) {
+    spheres.add(sphere_transform(snapshot.coinPos[i], snapshot.coinRadius),
+                YELLOW);
+  }
+
+  // The shadow pass draws each rope again from the same points, coarser
+  auto add_shadow_rope = [&](RopeTube rope) {
+    rope.sides = SHADOW_ROPE_SIDES;
+    add_rope(rope, assets.ropePoints, assets.shadowRopeTubes);
+  };
+  add_rope(snapshot.playerRope, assets.ropePoints, assets.ropeTubes);
+  add_shadow_rope(snapshot.playerRope);
+  add_fence(snapshot, frame.mouse_proj, assets.fenceTubes);
+
+  // A pen's ropes go into the batch of each view that sees it; its posts
+  // are shared by both passes, so they are kept if either does
+  const uint8_t SEEN_BY_EYE = 1;
+  const uint8_t SEEN_BY_LIGHT = 2;
+  bounds.clear();
+  for (const PenView& pen : snapshot.pens) {
+    add_pen_bounds(snapshot, pen, assets.ropePoints, bounds);
+  }
+  std::vector<uint8_t>& seen = assets.penSeen;
+  seen.assign(snapshot.pens.size(), 0);
+  eye.cull_spheres(bounds, visible);
+  for (uint32_t i : visible) {
+    seen[i] |= SEEN_BY_EYE;
+  }
+  light.cull_spheres(bounds, visible);
+  for (uint32_t i : visible) {
+    seen[i] |= SEEN_BY_LIGHT;
+  }
+  for (size_t i = 0; i < snapshot.pens.size(); i++) {
+    if (!seen[i]) {
+      continue;
+    }
+    const PenView& pen = snapshot.pens[i];
+    if (seen[i] & SEEN_BY_EYE) {
+      add_pen(snapshot, pen, assets.ropePoints, assets.ropeTubes);
+    }
+    if (seen[i] & SEEN_BY_LIGHT) {
+      for (uint32_t e = 0; e < pen.edgeCount; e++) {
+        add_shadow_rope(snapshot.penEdges[pen.firstEdge + e]);
+      }
+    }
+    // Posts run from the ground up to the rope height
+    for (uint32_t p = 0; p < pen.postCount; p++) {
+      const vec3& post = snapshot.posts[pen.firstPost + p];
+      posts.add(MatrixMultiply(MatrixScale(0.1f, 1.0f, 0.1f),
+                               MatrixTranslate(post.x, 0.0f, post.z)),
+                GRAY);
+    }
+  }
+}
+
+void add_pen(const RenderSnapshot& snapshot,
+             const PenView& pen,
+             const std::vector<vec3>& points,
+             TubeBatch& tubes) {
+  for (uint32_t e = 0; e < pen.edgeCount; e++) {
+    add_rope(snapshot.penEdges[pen.firstEdge + e], points, tubes);
+  }
+}
+
+void add_fence(const RenderSnapshot& snapshot, vec2 mouse, TubeBatch& tubes) {
+  const auto& points = snapshot.fencePoints;
+  if (points.empty()) {
+    return;
+  }
+  // The rail runs on to the mouse, or back to the start once close enough
+  // to close the fence
+  std::vector<vec3> rail;
+  for (const vec2& point : points) {
+    rail.push_back(vec2to3(point, 1.0));
+  }
+  if (Vector2Distance(points[0], mouse) > snapshot.fenceJoinDist) {
+    rail.push_back(vec2to3(mouse, 1.0));
+  } else {
+    rail.push_back(vec2to3(points[0], 1.0));
+  }
+  tubes.add(rail.data(), rail.size(), 0.1f, 10, BLUE);
+  if (points.size() < 2) {
+    return;
+  }
+  for (const vec2& point : points) {
+    tubes.add_segment(vec2to3(point, 0.0), vec2to3(point, 1.0), 0.1f, 8, GRAY);
+  }
+}
 
-  // Check if the screen position is within the screen bounds, accounting for
-  // the object's radius
-  bool is_visible =
-      (screenPos.x + radius > 0) && (screenPos.x - radius < screenWidth) &&
-      (screenPos.y + radius > 0) && (screenPos.y - radius < screenHeight);
+void draw_fence_join(const RenderSnapshot& snapshot) {
+  if (snapshot.fencePoints.size() < 2) {
+    return;
+  }
+  DrawCircle3D(vec2to3(snapshot.fencePoints[0], 1.0), snapshot.fenceJoinDist,
+               (Vector3){1.0, 0.0, 0.0}, 90, WHITE);
+}
 
-  return is_visible;
+void draw_scene(FrameState& frame,
+                SceneAssets& assets,
+                const Camera3D& viewer) {
+  assets.terrain->draw(Frustum::from_current_matrices(), viewer.position,
+                       1.0f);
+  draw_player(assets.playerTransform, assets.playerModel);
+  draw_fence_join(*frame.snapshot);
+
+  // One draw call each for the ropes, the fence being placed, the tether,
+  // animals and coins, and the posts
+  assets.ropeTubes.draw();
+  assets.fenceTubes.draw();
+  assets.spheres.draw(assets.sphereMesh, assets.instancedMaterial,
+                      assets.instanceColorLoc);
+  assets.posts.draw(assets.postMesh, assets.instancedMaterial,
+                    assets.instanceColorLoc);
 }
 
-void draw_scene(GameState& GameState) {
-  GameState.terrain->draw();
-  GameState.player->draw();
-  GameState.player->tether.draw();
-  GameState.player->rope.draw();
+void draw_shadow_casters(SceneAssets& assets, const Camera3D& viewer) {
+  // Grass detail follows the player's view, not the light's
+  assets.terrain->draw(Frustum::from_current_matrices(), viewer.position,
+                       GRASS_SHADOW_DENSITY);
+  draw_player(assets.playerTransform, assets.playerModel);
+  assets.shadowRopeTubes.draw();
+  assets.shadowSpheres.draw(assets.shadowSphereMesh, assets.instancedMaterial,
+                            assets.instanceColorLoc);
+  assets.posts.draw(assets.postMesh, assets.instancedMaterial,
+                    assets.instanceColorLoc);
+}
 
-  for (auto& animal : GameState.animals) {
-    if (is_in_camera_view(animal->pos, animal->species.radius, GameState.camera,
-                          GameState.screenWidth, GameState.screenHeight))
-      animal->draw();
+// Bilinear, so the reduced targets average when drawn to and blend when
+// read back; clamped, so the blur does not wrap at the screen edges
+static RenderTexture2D load_dof_target(int width, int height) {
+  RenderTexture2D target = LoadRenderTexture(width, height);
+  if (target.id == 0) {
+    throw std::runtime_error("Failed to create DoF render target");
   }
-  GameState.fence->draw(GameState);
-  for (const auto& pen : GameState.pens) {
-    if (pen) {               // Check if the unique_ptr is not null
-      pen->draw(GameState);  // Call the draw method of Pen
+  SetTextureFilter(target.texture, TEXTURE_FILTER_BILINEAR);
+  SetTextureWrap(target.texture, TEXTURE_WRAP_CLAMP);
+  return target;
+}
+
+static void unload_dof_targets(DofPass& dof) {
+  for (RenderTexture2D* target : {&dof.scene, &dof.blurH, &dof.blurV}) {
+    if (target->id != 0) {
+      UnloadRenderTexture(*target);
     }
+    *target = {};
   }
-  // GameState.pens.draw();
 }
 
 void UnloadResources(Shader shadowShader,
                      RenderTexture2D shadowMap,
-                     GameState& GameState,
-                     Shader dofShader,
-                     RenderTexture2D dofTexture) {
+                     SceneAssets& assets,
+                     DofPass& dof) {
   UnloadShader(shadowShader);
-  UnloadModel(GameState.player->model);
-  UnloadModel(GameState.player->tether.model);
-  for (auto& animal : GameState.animals) {
-    UnloadModel(animal->model);
-  }
+  UnloadModel(assets.playerModel);
+  assets.spheres.unload();
+  assets.posts.unload();
+  assets.shadowSpheres.unload();
+  assets.ropeTubes.unload();
+  assets.shadowRopeTubes.unload();
+  assets.fenceTubes.unload();
+  UnloadMesh(assets.sphereMesh);
+  UnloadMesh(assets.shadowSphereMesh);
+  UnloadMesh(assets.postMesh);
+  UnloadShader(assets.instancedShader);
   UnloadShadowmapRenderTexture(shadowMap);
-  UnloadModel(GameState.terrain->planeModel);
-  UnloadShader(dofShader);
-  UnloadRenderTexture(dofTexture);
+  UnloadModel(assets.terrain->planeModel);
+  unload_dof_targets(dof);
+  UnloadShader(dof.blurShader);
+  UnloadShader(dof.compositeShader);
 }
 
-RenderTexture2D SetupDofTexture(int screenWidth, int screenHeight) {
-  RenderTexture2D dofTexture = LoadRenderTexture(screenWidth, screenHeight);
-  if (dofTexture.id == 0) {
-    throw std::runtime_error("Failed to create dofTexture");
+void SetupDofTexture(DofPass& dof, int screenWidth, int screenHeight) {
+  unload_dof_targets(dof);
+  dof.scene = load_dof_target(screenWidth, screenHeight);
+  if (dof.quality != DofQuality::OFF) {
+    const int divisor = dof.quality == DofQuality::HIGH ? 2 : 4;
+    const int width = std::max(1, screenWidth / divisor);
+    const int height = std::max(1, screenHeight / divisor);
+    dof.blurH = load_dof_target(width, height);
+    dof.blurV = load_dof_target(width, height);
   }
-  return dofTexture;
+  dof.blur.set(dof.blurResolution,
+               Vector2{(float)screenWidth, (float)screenHeight});
 }
 
-rl::Shader SetupDofShader(int screenWidth, int screenHeight) {
-  rl::Shader dofShader(0, TextFormat("resources/shaders/dof.fs", GLSL_VERSION));
-  if (dofShader.id == 0) {
-    throw std::runtime_error("Failed to compile DoF shader");
+DofPass SetupDofShader(int screenWidth, int screenHeight) {
+  DofPass dof;
+  dof.blurShader = LoadShader(
+      0, TextFormat("resources/shaders/dof_blur.fs", GLSL_VERSION));
+  dof.compositeShader = LoadShader(
+      0, TextFormat("resources/shaders/dof_composite.fs", GLSL_VERSION));
+  if (dof.blurShader.id == 0 || dof.compositeShader.id == 0) {
+    throw std::runtime_error("Failed to compile DoF shaders");
   }
 
-  float blurRadius = 3.0f;
-  float resolution[2] = {(float)screenWidth, (float)screenHeight};
-  SetShaderValue(dofShader, GetShaderLocation(dofShader, "resolution"),
-                 resolution, SHADER_UNIFORM_VEC2);
-  SetShaderValue(dofShader, GetShaderLocation(dofShader, "radius"), &blurRadius,
-                 SHADER_UNIFORM_FLOAT);
+  const float blurRadius = 3.0f;
+  dof.blur = ShaderProgram(dof.blurShader);
+  dof.blurDirection = dof.blur.uniform("direction");
+  dof.blurResolution = dof.blur.uniform("resolution");
+  dof.blur.set(dof.blur.uniform("radius"), blurRadius);
+  ShaderProgram composite(dof.compositeShader);
+  composite.set(composite.uniform("radius"), blurRadius);
+  composite.flush();
+  dof.blurredLoc = GetShaderLocation(dof.compositeShader, "blurred");
+
+  SetupDofTexture(dof, screenWidth, screenHeight);
+  return dof;
+}
+
+void SetDofQuality(DofPass& dof, DofQuality quality) {
+  dof.quality = quality;
+  SetupDofTexture(dof, dof.scene.texture.width, dof.scene.texture.height);
+}
+
+// Render targets are stored bottom-up, hence the negative source height
+static Rectangle flipped(const Texture2D& texture) {
+  return {0.0f, 0.0f, (float)texture.width, (float)-texture.height};
+}
+
+static void blur_pass(DofPass& dof,
+                      const Texture2D& source,
+                      const RenderTexture2D& target,
+                      Vector2 direction) {
+  dof.blur.set(dof.blurDirection, direction);
+  dof.blur.flush();
+  BeginTextureMode(target);
+  BeginShaderMode(dof.blurShader);
+  DrawTexturePro(source, flipped(source),
+                 {0.0f, 0.0f, (float)target.texture.width,
+                  (float)target.texture.height},
+                 Vector2Zero(), 0.0f, WHITE);
+  EndShaderMode();
+  EndTextureMode();
+}
 
-  return dofShader;
+void RenderDof(DofPass& dof) {
+  const Texture2D& scene = dof.scene.texture;
+  if (dof.quality == DofQuality::OFF) {
+    DrawTextureRec(scene, flipped(scene), Vector2Zero(), WHITE);
+    return;
+  }
+  blur_pass(dof, scene, dof.blurH, {1.0f, 0.0f});
+  blur_pass(dof, dof.blurH.texture, dof.blurV, {0.0f, 1.0f});
+
+  BeginShaderMode(dof.compositeShader);
+  SetShaderValueTexture(dof.compositeShader, dof.blurredLoc,
+                        dof.blurV.texture);
+  DrawTextureRec(scene, flipped(scene), Vector2Zero(), WHITE);
+  EndShaderMode();
 }
 
-rl::Shader SetupShadowShader(vec3& lightDir) {
+rl::Shader SetupShadowShader() {
   rl::Shader shadowShader(
       TextFormat("resources/shaders/lighting.vs", GLSL_VERSION),
       TextFormat("resources/shaders/lighting.fs", GLSL_VERSION));
-  shadowShader.locs[SHADER_LOC_VECTOR_VIEW] =
-      GetShaderLocation(shadowShader, "viewPos");
-  Color lightColor = WHITE;
-  Vector4 lightColorNormalized = ColorNormalize(lightColor);
-  int lightDirLoc = GetShaderLocation(shadowShader, "lightDir");
-  int lightColLoc = GetShaderLocation(shadowShader, "lightColor");
-  SetShaderValue(shadowShader, lightDirLoc, &lightDir, SHADER_UNIFORM_VEC3);
-  SetShaderValue(shadowShader, lightColLoc, &lightColorNormalized,
-                 SHADER_UNIFORM_VEC4);
-  int ambientLoc = GetShaderLocation(shadowShader, "ambient");
-  float ambient[4] = {0.1f, 0.1f, 0.1f, 1.0f};
-  SetShaderValue(shadowShader, ambientLoc, ambient, SHADER_UNIFORM_VEC4);
-  int lightVPLoc = GetShaderLocation(shadowShader, "lightVP");
-  int shadowMapLoc = GetShaderLocation(shadowShader, "shadowMap");
-  int shadowMapResolution = SHADOWMAP_RESOLUTION;
-  SetShaderValue(shadowShader,
-                 GetShaderLocation(shadowShader, "shadowMapResolution"),
-                 &shadowMapResolution, SHADER_UNIFORM_INT);
-
   return shadowShader;
 }
 
-void RenderShadowMap(Shader shadowShader,
-                     RenderTexture2D& shadowMap,
+Shader SetupInstancedShader() {
+  Shader instancedShader = LoadShader(
+      TextFormat("resources/shaders/instanced.vs", GLSL_VERSION),
+      TextFormat("resources/shaders/instanced.fs", GLSL_VERSION));
+  if (instancedShader.id == 0) {
+    throw std::runtime_error("Failed to compile instanced shader");
+  }
+  instancedShader.locs[SHADER_LOC_MATRIX_MODEL] =
+      GetShaderLocationAttrib(instancedShader, "instanceTransform");
+
+  return instancedShader;
+}
+
+void update_uniforms(SceneAssets& assets,
+                     const Camera3D& view,
+                     const Camera3D& lightCam,
+                     const vec3& lightDir) {
+  // The shadow map is square
+  const Matrix lightViewProj = camera_matrix(lightCam, 1.0f);
+  for (LitProgram* lit : {&assets.lit, &assets.instancedLit}) {
+    lit->program.set(lit->viewPos, view.position);
+    lit->program.set(lit->lightDir, lightDir);
+    lit->program.set(lit->lightVP, lightViewProj);
+    lit->program.flush();
+  }
+  assets.terrain->grass.flush();
+}
+
+void RenderShadowMap(RenderTexture2D& shadowMap,
                      Camera3D& lightCam,
-                     GameState& GameState) {
+                     FrameState& frame,
+                     SceneAssets& assets) {
+  PROFILE_SCOPE("RenderShadowMap");
   BeginTextureMode(shadowMap);
   ClearBackground(WHITE);
   BeginMode3D(lightCam);
-  Matrix lightViewProj =
-      MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection());
-  SetShaderValueMatrix(shadowShader, GetShaderLocation(shadowShader, "lightVP"),
-                       lightViewProj);
-  RenderUtils::draw_scene(GameState);
+  RenderUtils::draw_shadow_casters(assets, frame.view);
   EndMode3D();
   EndTextureMode();
 }
 
 void RenderSceneToTexture(RenderTexture2D& dofTexture,
                           Camera3D& camera,
-                          rl::Shader& shadowShader,
                           RenderTexture2D& shadowMap,
-                          GameState& GameState) {
+                          FrameState& frame,
+                          SceneAssets& assets) {
+  PROFILE_SCOPE("RenderSceneToTexture");
   BeginTextureMode(dofTexture);
   ClearBackground(RAYWHITE);
 
-  rlEnableShader(shadowShader.id);
-  int slot = 10;
-  rlActiveTextureSlot(10);
+  rlActiveTextureSlot(SHADOW_MAP_SLOT);
   rlEnableTexture(shadowMap.depth.id);
-  rlSetUniform(GetShaderLocation(shadowShader, "shadowMap"), &slot,
-               SHADER_UNIFORM_INT, 1);
-
-  rlDisableShader();
   BeginMode3D(camera);
-  RenderUtils::draw_scene(GameState);
+  RenderUtils::draw_scene(frame, assets, camera);
   EndMode3D();
 
   EndTextureMode();
 }
 
-void HandleWindowResize(GameState& GameState,
+void HandleWindowResize(FrameState& frame,
                         int& screenWidth,
                         int& screenHeight,
-                        RenderTexture2D& dofTexture,
-                        Shader& dofShader) {
+                        DofPass& dof) {
   if (IsWindowResized()) {
     screenWidth = GetScreenWidth();
-    GameState.screenWidth = screenWidth;
+    frame.screenWidth = screenWidth;
     screenHeight = GetScreenHeight();
-    GameState.screenHeight = screenHeight;
-
-    // Re-create the DOF texture with the new screen size
-    UnloadRenderTexture(dofTexture);
-    dofTexture = RenderUtils::SetupDofTexture(screenWidth, screenHeight);
+    frame.screenHeight = screenHeight;
 
-    // Re-apply the resolution to the shader
-    float resolution[2] = {(float)screenWidth, (float)screenHeight};
-    SetShaderValue(dofShader, GetShaderLocation(dofShader, "resolution"),
-                   resolution, SHADER_UNIFORM_VEC2);
+    // Re-create the DoF chain's targets, and its resolution, for the new
+    // screen size
+    RenderUtils::SetupDofTexture(dof, screenWidth, screenHeight);
 
     // Update the viewport to match the new window size
     rlViewport(0, 0, screenWidth, screenHeight);
   }
 }
 
-void DrawGUI(GameState& GameState, int& screenWidth, int& screenHeight) {
+void DrawGUI(FrameState& frame, int& screenWidth, int& screenHeight) {
+  PROFILE_SCOPE("DrawGUI");
   float width = 40.0;
   float height = 40.0;
   float margin = 20.0;
   float textWidth = 200.0;
   float textHeight = 100.0;
-  std::string labelText = "Coins: " + std::to_string(GameState.coins);
+  std::string labelText = "Coins: " + std::to_string(frame.snapshot->coins);
   GuiToggleGroup(
       (Rectangle){static_cast<float>(screenWidth - width - margin),
                   static_cast<float>(screenHeight - (4.05 * height) - margin),
                   width, height},
-      "#1#\n#3#\n#8#\n#23#", &GameState.itemActive);
+      "#1#\n#3#\n#8#\n#23#", &frame.itemActive);
   GuiLabel((Rectangle){static_cast<float>(width / 2 + margin),
                        static_cast<float>(margin), textWidth, textHeight},
            labelText.c_str());
+#if WRANGLER_PROFILE
+  DrawProfilerBar(width / 2 + margin + textWidth, margin + 30.0f);
+#endif
+}
+
+#if WRANGLER_PROFILE
+void DrawProfilerBar(float x, float y) {
+  const float width = 360.0f;
+  const float rowHeight = 12.0f;
+  const int rows = 5;
+  const double budget = 1e9 / 60.0;  // Full width is one 60 Hz frame
+
+  DrawRectangle(x, y, width, rowHeight * rows, Fade(BLACK, 0.35f));
+  std::vector<Profiler::Event> frame = Profiler::last_frame();
+  if (frame.empty()) {
+    return;
+  }
+  const uint64_t origin = frame.back().start;
+  for (const Profiler::Event& event : frame) {
+    if (event.depth >= static_cast<uint32_t>(rows)) {
+      continue;
+    }
+    float left = width * static_cast<float>((event.start - origin) / budget);
+    float span = width * static_cast<float>(event.duration / budget);
+    if (left >= width) {
+      continue;
+    }
+    span = std::max(1.0f, std::min(span, width - left));
+    // Color by name, so a stage keeps its color from frame to frame
+    uint32_t hash = 2166136261u;
+    for (const char* c = event.name; *c; c++) {
+      hash = (hash ^ static_cast<unsigned char>(*c)) * 16777619u;
+    }
+    float hue = static_cast<float>(hash % 360);
+    Rectangle rect = {x + left, y + rowHeight * event.depth, span,
+                      rowHeight - 1.0f};
+    DrawRectangleRec(rect, ColorFromHSV(hue, 0.5f, 0.95f));
+    if (MeasureText(event.name, 10) + 4 < span) {
+      DrawText(event.name, rect.x + 2, rect.y + 1, 10, BLACK);
+    }
+  }
+  DrawText(TextFormat("%.2f ms", frame.back().duration * 1e-6), x + width + 6,
+           y, 10, BLACK);
 }
+#endif
 }  // namespace RenderUtils
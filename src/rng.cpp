@@ -0,0 +1,41 @@
+#include "rng.hpp"
+
+static uint64_t mix(uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+// Each key word goes through the finalizer on its own, so (a, b) and (b, a)
+// name different streams
+RandomStream::RandomStream(uint64_t seed,
+                           RandomDomain domain,
+                           uint64_t key,
+                           uint64_t subkey) {
+  uint64_t h = mix(seed + 0x9e3779b97f4a7c15ULL);
+  h = mix(h ^ static_cast<uint64_t>(domain));
+  h = mix(h ^ key);
+  base = mix(h ^ subkey);
+}
+
+uint64_t RandomStream::next_u64() {
+  return mix(base + 0x9e3779b97f4a7c15ULL * ++counter);
+}
+
+float RandomStream::next_float() {
+  // Top 24 bits fill the float mantissa exactly
+  return static_cast<float>(next_u64() >> 40) * (1.0f / 16777216.0f);
+}
+
+float RandomStream::uniform(float min, float max) {
+  return min + (max - min) * next_float();
+}
+
+int RandomStream::uniform_int(int min, int max) {
+  // Multiply-shift range reduction; the bias is below 2^-32 for game ranges
+  uint64_t range = static_cast<uint64_t>(static_cast<int64_t>(max) - min) + 1;
+  return min + static_cast<int>(((next_u64() >> 32) * range) >> 32);
+}
@@ -0,0 +1,163 @@
+#include "rope_system.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "simd.hpp"
+
+RopeId RopeSystem::add_rope(const raylib::Vector3* points,
+                            uint32_t count,
+                            uint32_t capacity,
+                            float maxSegmentLength,
+                            float friction) {
+  capacity = std::max(capacity, count);
+  const uint32_t offset = static_cast<uint32_t>(x.size());
+  const size_t size = offset + capacity;
+  x.resize(size);
+  y.resize(size);
+  z.resize(size);
+  maxLength.resize(size, maxSegmentLength);
+  step.resize(size, 0.0f);
+  nextX.resize(size);
+  nextY.resize(size);
+  nextZ.resize(size);
+
+  RopeId rope = static_cast<RopeId>(ropes.size());
+  ropes.push_back({offset, 0, capacity, friction});
+  for (uint32_t i = 0; i < capacity; i++) {
+    const raylib::Vector3& pos = points[std::min(i, count - 1)];
+    x[offset + i] = pos.x;
+    y[offset + i] = pos.y;
+    z[offset + i] = pos.z;
+  }
+  set_count(rope, count, points[count - 1]);
+  return rope;
+}
+
+void RopeSystem::set_count(RopeId rope, uint32_t count, raylib::Vector3 fill) {
+  Range& range = ropes[rope];
+  count = std::min(count, range.capacity);
+  for (uint32_t i = range.count; i < count; i++) {
+    x[range.offset + i] = fill.x;
+    y[range.offset + i] = fill.y;
+    z[range.offset + i] = fill.z;
+  }
+  range.count = count;
+  // Interior particles move; both ends and any unused capacity stay put
+  for (uint32_t i = 0; i < range.capacity; i++) {
+    bool free = i > 0 && i + 1 < count;
+    step[range.offset + i] = free ? range.friction : 0.0f;
+  }
+}
+
+void RopeSystem::set_point(RopeId rope, uint32_t i, raylib::Vector3 pos) {
+  uint32_t p = ropes[rope].offset + i;
+  x[p] = pos.x;
+  y[p] = pos.y;
+  z[p] = pos.z;
+}
+
+void RopeSystem::displace(RopeId rope, uint32_t i, raylib::Vector3 delta) {
+  uint32_t p = ropes[rope].offset + i;
+  x[p] += delta.x;
+  y[p] += delta.y;
+  z[p] += delta.z;
+}
+
+// One Jacobi sweep over particles [begin, end), reading x/y/z and writing
+// next*. Neighbors of a free particle always belong to the same rope since
+// rope ends are pinned, so the buffer can be walked without rope lookups.
+void RopeSystem::relax(size_t begin, size_t end) {
+  const simd::float4 half = simd::splat(0.5f);
+  const simd::float4 one = simd::splat(1.0f);
+  const simd::float4 tiny = simd::splat(1e-20f);
+  size_t i = begin;
+  for (; i + 4 <= end; i += 4) {
+    simd::float4 px = simd::load(&x[i]);
+    simd::float4 py = simd::load(&y[i]);
+    simd::float4 pz = simd::load(&z[i]);
+    simd::float4 prevX = simd::load(&x[i - 1]);
+    simd::float4 prevY = simd::load(&y[i - 1]);
+    simd::float4 prevZ = simd::load(&z[i - 1]);
+    simd::float4 nextPX = simd::load(&x[i + 1]);
+    simd::float4 nextPY = simd::load(&y[i + 1]);
+    simd::float4 nextPZ = simd::load(&z[i + 1]);
+    simd::float4 limit = simd::load(&maxLength[i]);
+
+    // Clamp both segments to the length limit
+    simd::float4 toPrevX = px - prevX;
+    simd::float4 toPrevY = py - prevY;
+    simd::float4 toPrevZ = pz - prevZ;
+    simd::float4 prevLen = simd::sqrt(toPrevX * toPrevX + toPrevY * toPrevY +
+                                      toPrevZ * toPrevZ);
+    simd::float4 prevScale = simd::select_gt(
+        prevLen, limit, limit / simd::max(prevLen, tiny), one);
+    simd::float4 toNextX = nextPX - px;
+    simd::float4 toNextY = nextPY - py;
+    simd::float4 toNextZ = nextPZ - pz;
+    simd::float4 nextLen = simd::sqrt(toNextX * toNextX + toNextY * toNextY +
+                                      toNextZ * toNextZ);
+    simd::float4 nextScale = simd::select_gt(
+        nextLen, limit, limit / simd::max(nextLen, tiny), one);
+
+    simd::float4 targetX =
+        (prevX + toPrevX * prevScale + nextPX - toNextX * nextScale) * half;
+    simd::float4 targetY =
+        (prevY + toPrevY * prevScale + nextPY - toNextY * nextScale) * half;
+    simd::float4 targetZ =
+        (prevZ + toPrevZ * prevScale + nextPZ - toNextZ * nextScale) * half;
+    simd::float4 s = simd::load(&step[i]);
+    simd::store(&nextX[i], px + (targetX - px) * s);
+    simd::store(&nextY[i], py + (targetY - py) * s);
+    simd::store(&nextZ[i], pz + (targetZ - pz) * s);
+  }
+  for (; i < end; i++) {
+    float limit = maxLength[i];
+    float toPrevX = x[i] - x[i - 1];
+    float toPrevY = y[i] - y[i - 1];
+    float toPrevZ = z[i] - z[i - 1];
+    float prevLen = std::sqrt(toPrevX * toPrevX + toPrevY * toPrevY +
+                              toPrevZ * toPrevZ);
+    float prevScale = prevLen > limit ? limit / prevLen : 1.0f;
+    float toNextX = x[i + 1] - x[i];
+    float toNextY = y[i + 1] - y[i];
+    float toNextZ = z[i + 1] - z[i];
+    float nextLen = std::sqrt(toNextX * toNextX + toNextY * toNextY +
+                              toNextZ * toNextZ);
+    float nextScale = nextLen > limit ? limit / nextLen : 1.0f;
+
+    float targetX =
+        (x[i - 1] + toPrevX * prevScale + x[i + 1] - toNextX * nextScale) *
+        0.5f;
+    float targetY =
+        (y[i - 1] + toPrevY * prevScale + y[i + 1] - toNextY * nextScale) *
+        0.5f;
+    float targetZ =
+        (z[i - 1] + toPrevZ * prevScale + z[i + 1] - toNextZ * nextScale) *
+        0.5f;
+    nextX[i] = x[i] + (targetX - x[i]) * step[i];
+    nextY[i] = y[i] + (targetY - y[i]) * step[i];
+    nextZ[i] = z[i] + (targetZ - z[i]) * step[i];
+  }
+}
+
+void RopeSystem::solve() {
+  const size_t size = x.size();
+  if (size < 3) {
+    return;
+  }
+  for (int it = 0; it < iterations; it++) {
+    // The first and last particles of the buffer are rope ends
+    nextX[0] = x[0];
+    nextY[0] = y[0];
+    nextZ[0] = z[0];
+    nextX[size - 1] = x[size - 1];
+    nextY[size - 1] = y[size - 1];
+    nextZ[size - 1] = z[size - 1];
+    relax(1, size - 1);
+    std::swap(x, nextX);
+    std::swap(y, nextY);
+    std::swap(z, nextZ);
+  }
+}
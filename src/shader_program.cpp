@@ -0,0 +1,83 @@
+#include "shader_program.hpp"
+
+#include <cstring>
+
+uint64_t ShaderProgram::sent = 0;
+uint64_t ShaderProgram::skipped = 0;
+
+ShaderProgram::ShaderProgram(Shader shader) : program(shader) {}
+
+ShaderProgram::Uniform ShaderProgram::uniform(const char* name) {
+  for (size_t i = 0; i < slots.size(); i++) {
+    if (slots[i].name == name) {
+      return static_cast<Uniform>(i);
+    }
+  }
+  Slot slot;
+  slot.name = name;
+  slot.location = GetShaderLocation(program, name);
+  slots.push_back(slot);
+  return static_cast<Uniform>(slots.size() - 1);
+}
+
+void ShaderProgram::stage(Uniform uniform,
+                          const void* value,
+                          size_t size,
+                          int type) {
+  Slot& slot = slots[uniform];
+  if (slot.pending) {
+    skipped++;  // Overwritten before it was sent
+  }
+  std::memcpy(slot.staged, value, size);
+  slot.size = size;
+  slot.type = type;
+  slot.pending = true;
+}
+
+void ShaderProgram::set(Uniform uniform, int value) {
+  stage(uniform, &value, sizeof(value), SHADER_UNIFORM_INT);
+}
+
+void ShaderProgram::set(Uniform uniform, float value) {
+  stage(uniform, &value, sizeof(value), SHADER_UNIFORM_FLOAT);
+}
+
+void ShaderProgram::set(Uniform uniform, Vector2 value) {
+  stage(uniform, &value, sizeof(value), SHADER_UNIFORM_VEC2);
+}
+
+void ShaderProgram::set(Uniform uniform, Vector3 value) {
+  stage(uniform, &value, sizeof(value), SHADER_UNIFORM_VEC3);
+}
+
+void ShaderProgram::set(Uniform uniform, Vector4 value) {
+  stage(uniform, &value, sizeof(value), SHADER_UNIFORM_VEC4);
+}
+
+void ShaderProgram::set(Uniform uniform, const Matrix& value) {
+  stage(uniform, &value, sizeof(value), MATRIX);
+}
+
+void ShaderProgram::flush() {
+  for (Slot& slot : slots) {
+    if (!slot.pending) {
+      continue;
+    }
+    slot.pending = false;
+    if (slot.everSent &&
+        std::memcmp(slot.staged, slot.uploaded, slot.size) == 0) {
+      skipped++;
+      continue;
+    }
+    if (slot.type == MATRIX) {
+      Matrix value;
+      std::memcpy(&value, slot.staged, sizeof(value));
+      SetShaderValueMatrix(program, slot.location, value);
+    } else {
+      SetShaderValue(program, slot.location, slot.staged, slot.type);
+    }
+    std::memcpy(slot.uploaded, slot.staged, slot.size);
+    slot.everSent = true;
+    sent++;
+  }
+}
@@ -0,0 +1,126 @@
+#include "sim_thread.hpp"
+
+#include <algorithm>
+
+#include "input_log.hpp"
+#include "profiler.hpp"
+#include "render_utils.hpp"
+#include "simulation.hpp"
+#include "snapshot.hpp"
+
+SimThread::SimThread(GameState& GameState,
+                     InputRecorder* recorder,
+                     Autosave& autosave,
+                     bool background)
+    : game(GameState),
+      recorder(recorder),
+      autosave(autosave),
+      background(background),
+      start(std::chrono::steady_clock::now()),
+      clock(PHYSICS_TIME) {
+#if defined(__EMSCRIPTEN__)
+  // The web build has no threads; tick from update()
+  this->background = false;
+#endif
+  // Something to draw before the first tick
+  save_tick(game, history);
+  capture_render_snapshot(game, history, snapshots.back());
+  snapshots.publish();
+  if (this->background) {
+    worker = std::thread(&SimThread::worker_loop, this);
+  }
+}
+
+SimThread::~SimThread() {
+  stopping = true;
+  if (worker.joinable()) {
+    worker.join();
+  }
+}
+
+double SimThread::now() const {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+void SimThread::send(const SimInput& input) {
+  std::lock_guard<std::mutex> lock(inputMutex);
+  queued.push_back(TimedInput{now(), input});
+}
+
+void SimThread::update() {
+  if (!background) {
+    run_due_ticks();
+  }
+}
+
+const RenderSnapshot& SimThread::latest() {
+  snapshots.acquire();
+  return snapshots.front();
+}
+
+float SimThread::alpha(const RenderSnapshot& snapshot) const {
+  float ticks = static_cast<float>((now() - snapshot.time) / PHYSICS_TIME);
+  return std::min(std::max(ticks, 0.0f), 1.0f);
+}
+
+void SimThread::worker_loop() {
+  PROFILE_THREAD("Simulation");
+  while (!stopping) {
+    run_due_ticks();
+    // Sleep until the next tick is due
+    std::this_thread::sleep_for(std::chrono::duration<double>(
+        (1.0f - clock.alpha()) * clock.tick_length()));
+  }
+}
+
+void SimThread::run_due_ticks() {
+  const double time = now();
+  const int ticks = clock.advance(static_cast<float>(time - lastAdvance));
+  lastAdvance = time;
+  // The last of them fell due alpha() ticks ago
+  const double last = time - clock.alpha() * clock.tick_length();
+  for (int tick = 0; tick < ticks; tick++) {
+    const double due = last - (ticks - 1 - tick) * clock.tick_length();
+    run_tick(take_input(due), due);
+  }
+}
+
+SimInput SimThread::take_input(double due) {
+  {
+    std::lock_guard<std::mutex> lock(inputMutex);
+    auto next = queued.begin();
+    for (; next != queued.end() && next->time <= due; ++next) {
+      // Keys and the mouse ray as last polled; clicks and wheel turns from
+      // every poll since the last tick
+      SimInput input = next->input;
+      input.placeFence = input.placeFence || held.placeFence;
+      input.undoFence = input.undoFence || held.undoFence;
+      input.zoom += held.zoom;
+      held = input;
+    }
+    queued.erase(queued.begin(), next);
+  }
+  SimInput input = held;
+  held.placeFence = false;
+  held.undoFence = false;
+  held.zoom = 0.0f;
+  return input;
+}
+
+void SimThread::run_tick(const SimInput& input, double due) {
+  save_tick(game, history);
+  step_simulation(game, input);
+  if (recorder) {
+    recorder->record(input, state_checksum(game));
+  }
+  autosave.update(game);
+  RenderUtils::update_camera(game, input);
+
+  PROFILE_SCOPE("Publish snapshot");
+  RenderSnapshot& snapshot = snapshots.back();
+  capture_render_snapshot(game, history, snapshot);
+  snapshot.time = due;
+  snapshots.publish();
+}
@@ -0,0 +1,91 @@
+#include "simulation.hpp"
+
+#include "animal.hpp"
+#include "buildings.hpp"
+#include "collectables.hpp"
+#include "pen_tracker.hpp"
+#include "physics.hpp"
+#include "player.hpp"
+#include "profiler.hpp"
+#include "rope_system.hpp"
+
+void step_simulation(GameState& GameState, const SimInput& input) {
+  PROFILE_SCOPE("Tick");
+  const float dt = PHYSICS_TIME;
+  GameState.itemActive = input.tool;
+  {
+    PROFILE_SCOPE("Building");
+    handle_building(GameState, input);
+  }
+
+  // Where the player and tether started, for swept coin pickup
+  const vec3 playerFrom = GameState.player->pos;
+  const vec3 tetherFrom = GameState.player->tether.pos;
+
+  handle_collisions(GameState, input, GameState.substeps);
+  GameState.substeps =
+      adapt_substeps(GameState.collisionStats, GameState.substeps);
+  {
+    PROFILE_SCOPE("Player");
+    GameState.player->tether.update(input, GameState, GameState.player->pos);
+    GameState.player->update(input);
+  }
+  {
+    PROFILE_SCOPE("Ropes");
+    GameState.player->rope.update(input, GameState.player->pos,
+                                  GameState.player->tether.pos, dt);
+    GameState.ropes->solve();
+  }
+  GameState.addAnimalTimer += dt;
+  if (GameState.addAnimalTimer > GameState.addAnimalInterval) {
+    GameState.addAnimalTimer = 0.0;
+    GameState.addAnimal();
+  }
+  {
+    PROFILE_SCOPE("Animals");
+    GameState.animals->update(dt, GameState.seed, GameState.tick);
+  }
+  {
+    PROFILE_SCOPE("Pens");
+    for (uint32_t p = 0; p < GameState.pens.size(); p++) {
+      GameState.pens[p]->update(GameState, p, dt);
+    }
+  }
+  {
+    PROFILE_SCOPE("Coins");
+    GameState.coinPool->expire(dt);
+    collect_coins(GameState, playerFrom, tetherFrom);
+  }
+  {
+    PROFILE_SCOPE("Pen tracker");
+    GameState.penTracker->update(GameState.pens, *GameState.animals);
+  }
+  GameState.tick++;
+}
+
+// FNV-1a over the raw bytes, so any bit of drift changes the result
+static uint64_t hash_bytes(uint64_t hash, const void* data, size_t size) {
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+uint64_t state_checksum(const GameState& GameState) {
+  const AnimalPool& animals = *GameState.animals;
+  const CoinPool& coins = *GameState.coinPool;
+  const Player& player = *GameState.player;
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  hash = hash_bytes(hash, animals.pos.data(), animals.size() * sizeof(vec3));
+  hash = hash_bytes(hash, animals.targ.data(), animals.size() * sizeof(vec3));
+  hash = hash_bytes(hash, &player.pos, sizeof(vec3));
+  const RopeSystem& ropes = *GameState.ropes;
+  const size_t particles = ropes.particle_count() * sizeof(float);
+  hash = hash_bytes(hash, ropes.xs(), particles);
+  hash = hash_bytes(hash, ropes.ys(), particles);
+  hash = hash_bytes(hash, ropes.zs(), particles);
+  hash = hash_bytes(hash, coins.pos.data(), coins.size() * sizeof(vec3));
+  hash = hash_bytes(hash, &GameState.coins, sizeof(GameState.coins));
+  return hash;
+}
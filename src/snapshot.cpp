@@ -0,0 +1,674 @@
+#include "snapshot.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+#include "animal.hpp"
+#include "buildings.hpp"
+#include "collectables.hpp"
+#include "fence_index.hpp"
+#include "pen_tracker.hpp"
+#include "physics.hpp"
+#include "player.hpp"
+#include "profiler.hpp"
+#include "rope_system.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SNAPSHOT_MMAP 1
+#endif
+
+static const char FILE_MAGIC[4] = {'W', 'R', 'S', 'V'};
+static const uint32_t FILE_COMPRESSED = 1;
+
+struct SnapshotFileHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t flags;
+  uint32_t reserved;
+  uint64_t imageSize;   // Bytes of the image once decompressed
+  uint64_t storedSize;  // Bytes that follow this header
+};
+static_assert(sizeof(SnapshotFileHeader) == 32, "file header is 32 bytes");
+
+// One flat array per section, in this order in the image
+enum Section : uint32_t {
+  ANIMAL_POS,
+  ANIMAL_TARG,
+  ANIMAL_SPECIES,
+  ANIMAL_RETARGET,
+  ANIMAL_SLOT_OF_INDEX,
+  ANIMAL_INDEX_OF_SLOT,
+  ANIMAL_GENERATION,
+  ANIMAL_FREE_SLOTS,
+  ROPE_RANGES,
+  ROPE_X,
+  ROPE_Y,
+  ROPE_Z,
+  ROPE_MAX_LENGTH,
+  ROPE_STEP,
+  PEN_RECORDS,
+  PEN_POINTS,
+  PEN_EDGES,
+  COIN_POS,
+  COIN_PEN,
+  COIN_TTL,
+  FENCE_POINTS,
+  SECTION_COUNT
+};
+
+struct SectionEntry {
+  uint64_t offset;  // From the start of the image
+  uint64_t count;
+  uint32_t elementSize;
+  uint32_t reserved;
+};
+
+struct PenRecord {
+  uint32_t firstPoint;  // Into PEN_POINTS
+  uint32_t pointCount;
+  uint32_t firstEdge;  // Into PEN_EDGES
+  uint32_t edgeCount;
+  float coinTimer;
+  uint32_t reserved[3];
+};
+
+struct RopeRecord {
+  uint32_t offset;
+  uint32_t count;
+  uint32_t capacity;
+  float friction;
+};
+
+struct PlayerRecord {
+  Vector3 pos, targ, com;
+  float angle, angleTarg, tilt, tiltTarg;
+  Matrix transform;
+  Vector3 tetherPos, tetherTarg;
+  float tetherMaxDistance;
+  Vector3 ropeStart, ropeEnd;
+  float ropeDeltaTimer;
+  int32_t ropePoints;
+  uint32_t ropeId;
+};
+
+struct ImageHeader {
+  uint64_t seed;
+  uint64_t tick;
+  uint64_t spawnDraws;  // Position of GameState::spawnRandom
+  float addAnimalInterval;
+  float addAnimalTimer;
+  int32_t coins;
+  int32_t substeps;
+  int32_t itemActive;
+  int32_t ropeIterations;
+  float fenceJoinDist;
+  uint32_t reserved;
+  PlayerRecord player;
+  SectionEntry sections[SECTION_COUNT];
+};
+
+static_assert(sizeof(vec3) == sizeof(Vector3), "vec3 is a plain Vector3");
+static_assert(sizeof(vec2) == sizeof(Vector2), "vec2 is a plain Vector2");
+static_assert(sizeof(AnimalHandle) == 8, "AnimalHandle is two words");
+
+static size_t align16(size_t n) {
+  return (n + 15) & ~static_cast<size_t>(15);
+}
+
+// Private state of the sim classes, reached through their friend
+// declarations
+struct SnapshotIO {
+  // Builds the image one section at a time
+  class Writer {
+   public:
+    Writer() : image(align16(sizeof(ImageHeader))) {}
+
+    ImageHeader& header() {
+      return *reinterpret_cast<ImageHeader*>(image.data());
+    }
+
+    template <typename T>
+    void add(Section section, const T* data, size_t count) {
+      static_assert(std::is_trivially_copyable<T>::value, "flat data only");
+      const size_t offset = image.size();
+      image.resize(align16(offset + count * sizeof(T)));
+      if (count > 0) {
+        std::memcpy(image.data() + offset, data, count * sizeof(T));
+      }
+      header().sections[section] = {offset, count, sizeof(T), 0};
+    }
+
+    template <typename T>
+    void add(Section section, const std::vector<T>& data) {
+      add(section, data.data(), data.size());
+    }
+
+    std::vector<uint8_t> image;
+  };
+
+  // Bounds-checked view of an image
+  class Reader {
+   public:
+    Reader(const uint8_t* image, size_t size) : image(image), size(size) {
+      if (size < sizeof(ImageHeader)) {
+        throw std::runtime_error("snapshot image is truncated");
+      }
+      std::memcpy(&header, image, sizeof(ImageHeader));
+    }
+
+    template <typename T>
+    void read(Section section, std::vector<T>& out) const {
+      const SectionEntry& entry = header.sections[section];
+      if (entry.elementSize != sizeof(T) || entry.offset > size ||
+          entry.count > (size - entry.offset) / sizeof(T)) {
+        throw std::runtime_error("snapshot section " +
+                                 std::to_string(section) + " is corrupt");
+      }
+      out.resize(entry.count);
+      if (entry.count > 0) {
+        std::memcpy(out.data(), image + entry.offset, entry.count * sizeof(T));
+      }
+    }
+
+    ImageHeader header;
+
+   private:
+    const uint8_t* image;
+    size_t size;
+  };
+
+  static std::vector<uint8_t> capture(const GameState& GameState);
+  static void restore(GameState& GameState, const Reader& reader);
+};
+
+std::vector<uint8_t> SnapshotIO::capture(const GameState& GameState) {
+  Writer writer;
+  ImageHeader& header = writer.header();
+  header.seed = GameState.seed;
+  header.tick = GameState.tick;
+  header.spawnDraws = GameState.spawnRandom.position();
+  header.addAnimalInterval = GameState.addAnimalInterval;
+  header.addAnimalTimer = GameState.addAnimalTimer;
+  header.coins = GameState.coins;
+  header.substeps = GameState.substeps;
+  header.itemActive = GameState.itemActive;
+  header.ropeIterations = GameState.ropes->iterations;
+  header.fenceJoinDist = GameState.fence->joinDist;
+
+  const Player& player = *GameState.player;
+  PlayerRecord& record = header.player;
+  record.pos = player.pos;
+  record.targ = player.targ;
+  record.com = player.com;
+  record.angle = player.angle;
+  record.angleTarg = player.angleTarg;
+  record.tilt = player.tilt;
+  record.tiltTarg = player.tiltTarg;
+  record.transform = player.transform;
+  record.tetherPos = player.tether.pos;
+  record.tetherTarg = player.tether.targ;
+  record.tetherMaxDistance = player.tether.maxDistance;
+  record.ropeStart = player.rope.start;
+  record.ropeEnd = player.rope.end;
+  record.ropeDeltaTimer = player.rope.deltaTimer;
+  record.ropePoints = player.rope.num_points;
+  record.ropeId = player.rope.id;
+
+  // The image grows below; `header` and `record` are not used past here
+  const AnimalPool& animals = *GameState.animals;
+  writer.add(ANIMAL_POS, animals.pos);
+  writer.add(ANIMAL_TARG, animals.targ);
+  writer.add(ANIMAL_SPECIES, animals.species);
+  writer.add(ANIMAL_RETARGET, animals.retargetTimer);
+  writer.add(ANIMAL_SLOT_OF_INDEX, animals.slotOfIndex);
+  writer.add(ANIMAL_INDEX_OF_SLOT, animals.indexOfSlot);
+  writer.add(ANIMAL_GENERATION, animals.slotGeneration);
+  writer.add(ANIMAL_FREE_SLOTS, animals.freeSlots);
+
+  const RopeSystem& ropes = *GameState.ropes;
+  std::vector<RopeRecord> ranges;
+  ranges.reserve(ropes.ropes.size());
+  for (const RopeSystem::Range& range : ropes.ropes) {
+    ranges.push_back(
+        {range.offset, range.count, range.capacity, range.friction});
+  }
+  writer.add(ROPE_RANGES, ranges);
+  writer.add(ROPE_X, ropes.x);
+  writer.add(ROPE_Y, ropes.y);
+  writer.add(ROPE_Z, ropes.z);
+  writer.add(ROPE_MAX_LENGTH, ropes.maxLength);
+  writer.add(ROPE_STEP, ropes.step);
+
+  std::vector<PenRecord> pens;
+  std::vector<Vector3> points;
+  std::vector<RopeId> edges;
+  pens.reserve(GameState.pens.size());
+  for (const auto& pen : GameState.pens) {
+    PenRecord record = {};
+    record.firstPoint = static_cast<uint32_t>(points.size());
+    record.pointCount = static_cast<uint32_t>(pen->fixed_points.size());
+    record.firstEdge = static_cast<uint32_t>(edges.size());
+    record.edgeCount = static_cast<uint32_t>(pen->edges.size());
+    record.coinTimer = pen->coinTimer;
+    pens.push_back(record);
+    points.insert(points.end(), pen->fixed_points.begin(),
+                  pen->fixed_points.end());
+    edges.insert(edges.end(), pen->edges.begin(), pen->edges.end());
+  }
+  writer.add(PEN_RECORDS, pens);
+  writer.add(PEN_POINTS, points);
+  writer.add(PEN_EDGES, edges);
+
+  const CoinPool& coins = *GameState.coinPool;
+  writer.add(COIN_POS, coins.pos);
+  writer.add(COIN_PEN, coins.pen);
+  writer.add(COIN_TTL, coins.ttl);
+
+  writer.add(FENCE_POINTS, GameState.fence->points);
+  return std::move(writer.image);
+}
+
+void SnapshotIO::restore(GameState& GameState, const Reader& reader) {
+  const ImageHeader& header = reader.header;
+
+  // Everything is read into temporaries and checked before GameState is
+  // touched, so a bad image leaves the running world as it was
+  AnimalPool animals;
+  reader.read(ANIMAL_POS, animals.pos);
+  reader.read(ANIMAL_TARG, animals.targ);
+  reader.read(ANIMAL_SPECIES, animals.species);
+  reader.read(ANIMAL_RETARGET, animals.retargetTimer);
+  reader.read(ANIMAL_SLOT_OF_INDEX, animals.slotOfIndex);
+  reader.read(ANIMAL_INDEX_OF_SLOT, animals.indexOfSlot);
+  reader.read(ANIMAL_GENERATION, animals.slotGeneration);
+  reader.read(ANIMAL_FREE_SLOTS, animals.freeSlots);
+
+  std::vector<RopeRecord> ranges;
+  std::vector<float> x, y, z, maxLength, step;
+  reader.read(ROPE_RANGES, ranges);
+  reader.read(ROPE_X, x);
+  reader.read(ROPE_Y, y);
+  reader.read(ROPE_Z, z);
+  reader.read(ROPE_MAX_LENGTH, maxLength);
+  reader.read(ROPE_STEP, step);
+
+  std::vector<PenRecord> pens;
+  std::vector<vec3> points;
+  std::vector<RopeId> edges;
+  reader.read(PEN_RECORDS, pens);
+  reader.read(PEN_POINTS, points);
+  reader.read(PEN_EDGES, edges);
+
+  std::vector<vec3> coinPos;
+  std::vector<uint32_t> coinPen;
+  std::vector<float> coinTtl;
+  reader.read(COIN_POS, coinPos);
+  reader.read(COIN_PEN, coinPen);
+  reader.read(COIN_TTL, coinTtl);
+
+  std::vector<vec2> fencePoints;
+  reader.read(FENCE_POINTS, fencePoints);
+
+  const size_t particles = x.size();
+  bool consistent =
+      animals.targ.size() == animals.size() &&
+      animals.species.size() == animals.size() &&
+      animals.retargetTimer.size() == animals.size() &&
+      animals.slotOfIndex.size() == animals.size() &&
+      y.size() == particles && z.size() == particles &&
+      maxLength.size() == particles && step.size() == particles &&
+      coinPen.size() == coinPos.size() && coinTtl.size() == coinPos.size() &&
+      header.player.ropeId < ranges.size() &&
+      header.substeps >= MIN_SUBSTEPS && header.substeps <= MAX_SUBSTEPS &&
+      header.ropeIterations >= 1 &&
+      header.ropeIterations <= RopeSystem::MAX_ITERATIONS;
+  for (const RopeRecord& range : ranges) {
+    consistent = consistent && range.count <= range.capacity &&
+                 range.offset <= particles &&
+                 range.capacity <= particles - range.offset;
+  }
+  // A pen is a closed polygon with one edge rope per post, and both ends
+  // of every rope are pinned, so each needs at least two particles
+  for (const PenRecord& pen : pens) {
+    consistent = consistent && pen.firstPoint <= points.size() &&
+                 pen.pointCount <= points.size() - pen.firstPoint &&
+                 pen.firstEdge <= edges.size() &&
+                 pen.edgeCount <= edges.size() - pen.firstEdge &&
+                 pen.pointCount >= 3 && pen.edgeCount == pen.pointCount;
+  }
+  for (RopeId edge : edges) {
+    consistent = consistent && edge < ranges.size() && ranges[edge].count >= 2;
+  }
+  for (uint32_t pen : coinPen) {
+    consistent = consistent && pen < pens.size();
+  }
+  // The player's rope id was checked above, before its range is read
+  consistent = consistent && ranges[header.player.ropeId].count >= 2 &&
+               header.player.ropePoints >= 0 &&
+               static_cast<uint32_t>(header.player.ropePoints) <=
+                   ranges[header.player.ropeId].capacity;
+  for (SpeciesType species : animals.species) {
+    // species_info() indexes a table with it
+    consistent = consistent && static_cast<uint8_t>(species) <=
+                                   static_cast<uint8_t>(SpeciesType::COW);
+  }
+  // Every slot is either live, pointing at an index that points back, or
+  // free, exactly once. A free slot's indexOfSlot entry is whatever index
+  // it last held and is overwritten by AnimalPool::add before it is read.
+  const size_t slots = animals.indexOfSlot.size();
+  consistent = consistent && animals.slotGeneration.size() == slots &&
+               animals.size() + animals.freeSlots.size() == slots;
+  std::vector<uint8_t> slotUsed(consistent ? slots : 0, 0);
+  for (size_t i = 0; consistent && i < animals.slotOfIndex.size(); i++) {
+    uint32_t slot = animals.slotOfIndex[i];
+    consistent = slot < slots && !slotUsed[slot] &&
+                 animals.indexOfSlot[slot] == i;
+    if (consistent) {
+      slotUsed[slot] = 1;
+    }
+  }
+  for (size_t i = 0; consistent && i < animals.freeSlots.size(); i++) {
+    uint32_t slot = animals.freeSlots[i];
+    consistent = slot < slots && !slotUsed[slot];
+    if (consistent) {
+      slotUsed[slot] = 1;
+    }
+  }
+  if (!consistent) {
+    throw std::runtime_error("snapshot image is inconsistent");
+  }
+
+  GameState.seed = header.seed;
+  GameState.tick = header.tick;
+  GameState.spawnRandom = RandomStream(header.seed, RandomDomain::SPAWN);
+  GameState.spawnRandom.seek(header.spawnDraws);
+  GameState.addAnimalInterval = header.addAnimalInterval;
+  GameState.addAnimalTimer = header.addAnimalTimer;
+  GameState.coins = header.coins;
+  GameState.substeps = header.substeps;
+  GameState.itemActive = header.itemActive;
+
+  RopeSystem& ropes = *GameState.ropes;
+  ropes.iterations = header.ropeIterations;
+  ropes.ropes.clear();
+  for (const RopeRecord& range : ranges) {
+    ropes.ropes.push_back(
+        {range.offset, range.count, range.capacity, range.friction});
+  }
+  ropes.x = std::move(x);
+  ropes.y = std::move(y);
+  ropes.z = std::move(z);
+  ropes.maxLength = std::move(maxLength);
+  ropes.step = std::move(step);
+  ropes.nextX.assign(particles, 0.0f);
+  ropes.nextY.assign(particles, 0.0f);
+  ropes.nextZ.assign(particles, 0.0f);
+
+  *GameState.animals = std::move(animals);
+
+  Player& player = *GameState.player;
+  const PlayerRecord& record = header.player;
+  player.pos = record.pos;
+  player.targ = record.targ;
+  player.com = record.com;
+  player.angle = record.angle;
+  player.angleTarg = record.angleTarg;
+  player.tilt = record.tilt;
+  player.tiltTarg = record.tiltTarg;
+  player.transform = record.transform;
+  player.tether.pos = record.tetherPos;
+  player.tether.targ = record.tetherTarg;
+  player.tether.maxDistance = record.tetherMaxDistance;
+  player.rope.start = record.ropeStart;
+  player.rope.end = record.ropeEnd;
+  player.rope.deltaTimer = record.ropeDeltaTimer;
+  player.rope.num_points = record.ropePoints;
+  player.rope.id = record.ropeId;
+
+  GameState.pens.clear();
+  for (const PenRecord& pen : pens) {
+    auto restored = std::make_unique<Pen>(
+        std::vector<vec3>(points.begin() + pen.firstPoint,
+                          points.begin() + pen.firstPoint + pen.pointCount),
+        ropes,
+        std::vector<RopeId>(edges.begin() + pen.firstEdge,
+                            edges.begin() + pen.firstEdge + pen.edgeCount));
+    restored->coinTimer = pen.coinTimer;
+    GameState.pens.push_back(std::move(restored));
+  }
+
+  CoinPool& coins = *GameState.coinPool;
+  coins.clear();
+  for (size_t i = 0; i < coinPos.size(); i++) {
+    coins.add(coinPos[i], coinPen[i], coinTtl[i]);
+  }
+
+  GameState.fence->points = std::move(fencePoints);
+  GameState.fence->joinDist = header.fenceJoinDist;
+
+  // Membership is a function of positions; a fresh tracker finds it again
+  // and sets every pen's species on the way
+  GameState.fenceIndex = std::make_unique<FenceIndex>(GRID_SIZE);
+  GameState.penTracker = std::make_unique<PenTracker>();
+  GameState.penTracker->update(GameState.pens, *GameState.animals);
+}
+
+std::vector<uint8_t> capture_snapshot(const GameState& GameState) {
+  return SnapshotIO::capture(GameState);
+}
+
+void restore_snapshot(GameState& GameState,
+                      const uint8_t* image,
+                      size_t size) {
+  SnapshotIO::restore(GameState, SnapshotIO::Reader(image, size));
+}
+
+void write_snapshot_file(const std::string& path,
+                         const std::vector<uint8_t>& image,
+                         bool compress) {
+  SnapshotFileHeader header = {};
+  std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+  header.version = SNAPSHOT_VERSION;
+  header.imageSize = image.size();
+
+  const uint8_t* stored = image.data();
+  unsigned char* compressed = nullptr;
+  int compressedSize = 0;
+  if (compress) {
+    compressed = CompressData(image.data(), static_cast<int>(image.size()),
+                              &compressedSize);
+    if (!compressed) {
+      throw std::runtime_error("could not compress snapshot");
+    }
+    header.flags |= FILE_COMPRESSED;
+    stored = compressed;
+    header.storedSize = static_cast<uint64_t>(compressedSize);
+  } else {
+    header.storedSize = image.size();
+  }
+
+  const std::string partial = path + ".partial";
+  FILE* file = fopen(partial.c_str(), "wb");
+  bool ok = file && fwrite(&header, sizeof(header), 1, file) == 1 &&
+            fwrite(stored, 1, header.storedSize, file) == header.storedSize;
+  if (file) {
+    ok = fclose(file) == 0 && ok;
+  }
+  if (compressed) {
+    MemFree(compressed);
+  }
+  if (!ok || std::rename(partial.c_str(), path.c_str()) != 0) {
+    std::remove(partial.c_str());
+    throw std::runtime_error("could not write snapshot " + path);
+  }
+}
+
+// Check the file header and restore from the bytes that follow it
+static void restore_file_bytes(GameState& GameState,
+                               const std::string& path,
+                               const uint8_t* bytes,
+                               size_t size) {
+  SnapshotFileHeader header;
+  if (size < sizeof(header)) {
+    throw std::runtime_error(path + " is not a snapshot");
+  }
+  std::memcpy(&header, bytes, sizeof(header));
+  if (std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+    throw std::runtime_error(path + " is not a snapshot");
+  }
+  if (header.version != SNAPSHOT_VERSION) {
+    throw std::runtime_error(path + ": unsupported snapshot version " +
+                             std::to_string(header.version));
+  }
+  if (header.storedSize > size - sizeof(header)) {
+    throw std::runtime_error(path + " is truncated");
+  }
+  const uint8_t* stored = bytes + sizeof(header);
+  if (!(header.flags & FILE_COMPRESSED)) {
+    restore_snapshot(GameState, stored, header.storedSize);
+    return;
+  }
+  int imageSize = 0;
+  unsigned char* image = DecompressData(
+      stored, static_cast<int>(header.storedSize), &imageSize);
+  if (!image || static_cast<uint64_t>(imageSize) != header.imageSize) {
+    if (image) {
+      MemFree(image);
+    }
+    throw std::runtime_error(path + " does not decompress");
+  }
+  try {
+    restore_snapshot(GameState, image, imageSize);
+  } catch (...) {
+    MemFree(image);
+    throw;
+  }
+  MemFree(image);
+}
+
+void load_snapshot_file(GameState& GameState, const std::string& path) {
+#if defined(SNAPSHOT_MMAP)
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("cannot open snapshot " + path);
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size == 0) {
+    close(fd);
+    throw std::runtime_error(path + " is not a snapshot");
+  }
+  const size_t size = static_cast<size_t>(info.st_size);
+  void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    throw std::runtime_error("cannot map snapshot " + path);
+  }
+  try {
+    restore_file_bytes(GameState, path, static_cast<const uint8_t*>(mapped),
+                       size);
+  } catch (...) {
+    munmap(mapped, size);
+    throw;
+  }
+  munmap(mapped, size);
+#else
+  FILE* file = fopen(path.c_str(), "rb");
+  if (!file) {
+    throw std::runtime_error("cannot open snapshot " + path);
+  }
+  std::vector<uint8_t> bytes;
+  uint8_t chunk[1 << 16];
+  size_t read;
+  while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+    bytes.insert(bytes.end(), chunk, chunk + read);
+  }
+  fclose(file);
+  restore_file_bytes(GameState, path, bytes.data(), bytes.size());
+#endif
+}
+
+Autosave::Autosave(std::string path, uint64_t intervalTicks)
+    : path(std::move(path)), intervalTicks(intervalTicks) {
+#if !defined(__EMSCRIPTEN__)
+  worker = std::thread(&Autosave::worker_loop, this);
+#endif
+}
+
+Autosave::~Autosave() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  if (worker.joinable()) {
+    worker.join();
+  }
+}
+
+void Autosave::update(const GameState& GameState) {
+  if (GameState.tick < lastSaveTick + intervalTicks) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (busy) {
+      return;  // Still writing the last one; try again next tick
+    }
+    busy = true;
+  }
+  PROFILE_SCOPE("Autosave capture");
+  lastSaveTick = GameState.tick;
+  std::vector<uint8_t> image = capture_snapshot(GameState);
+#if defined(__EMSCRIPTEN__)
+  // The web build has no threads; save inline
+  try {
+    write_snapshot_file(path, image, true);
+    written++;
+  } catch (const std::exception& e) {
+    TraceLog(LOG_WARNING, "Autosave failed: %s", e.what());
+  }
+  busy = false;
+#else
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending = std::move(image);
+  }
+  wake.notify_one();
+#endif
+}
+
+uint64_t Autosave::saves_written() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return written;
+}
+
+void Autosave::worker_loop() {
+  PROFILE_THREAD("Autosave");
+  std::unique_lock<std::mutex> lock(mutex);
+  for (;;) {
+    wake.wait(lock, [this] { return stopping || !pending.empty(); });
+    if (pending.empty()) {
+      return;  // Stopping with nothing left to write
+    }
+    std::vector<uint8_t> image = std::move(pending);
+    pending.clear();
+    lock.unlock();
+    bool ok = true;
+    try {
+      PROFILE_SCOPE("Autosave write");
+      write_snapshot_file(path, image, true);
+    } catch (const std::exception& e) {
+      TraceLog(LOG_WARNING, "Autosave failed: %s", e.what());
+      ok = false;
+    }
+    lock.lock();
+    written += ok ? 1 : 0;
+    busy = false;
+  }
+}
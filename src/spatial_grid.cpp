@@ -0,0 +1,108 @@
+#include "spatial_grid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+SpatialGrid::SpatialGrid(float cellSize)
+    : cellSize(cellSize), invCellSize(1.0f / cellSize), bucketMask(0) {}
+
+uint64_t SpatialGrid::pack_key(int x, int z) {
+  return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) |
+         static_cast<uint32_t>(z);
+}
+
+// SplitMix64 finalizer: unlike XOR-ing the coordinates, (a, b) and (b, a)
+// land in different buckets and the diagonal does not collapse onto zero
+uint32_t SpatialGrid::bucket_of(uint64_t key) const {
+  key ^= key >> 30;
+  key *= 0xbf58476d1ce4e5b9ULL;
+  key ^= key >> 27;
+  key *= 0x94d049bb133111ebULL;
+  key ^= key >> 31;
+  return static_cast<uint32_t>(key) & bucketMask;
+}
+
+int SpatialGrid::cell_coord(float v) const {
+  return static_cast<int>(std::floor(v * invCellSize));
+}
+
+void SpatialGrid::build(const raylib::Vector3* positions, size_t count) {
+  // Keep the table at most half full
+  uint32_t bucketCountTarget = 64;
+  while (bucketCountTarget < 2 * count) {
+    bucketCountTarget <<= 1;
+  }
+  if (bucketCountTarget != bucketMask + 1) {
+    bucketMask = bucketCountTarget - 1;
+    bucketStart.resize(bucketCountTarget);
+    bucketCount.resize(bucketCountTarget);
+    bucketCell.resize(bucketCountTarget + 1);
+  }
+  itemKey.resize(count);
+  sorted.resize(count);
+  occupied.clear();
+  std::fill(bucketCount.begin(), bucketCount.end(), 0);
+
+  // Count items per bucket
+  for (size_t i = 0; i < count; i++) {
+    uint64_t key = pack_key(cell_coord(positions[i].x),
+                            cell_coord(positions[i].z));
+    itemKey[i] = key;
+    bucketCount[bucket_of(key)]++;
+  }
+
+  // Prefix sum into bucket offsets; bucketCell doubles as the scatter cursor
+  uint32_t offset = 0;
+  for (uint32_t b = 0; b <= bucketMask; b++) {
+    bucketStart[b] = offset;
+    bucketCell[b] = offset;
+    offset += bucketCount[b];
+  }
+
+  // Scatter in item order, so each bucket starts out sorted by index
+  for (size_t i = 0; i < count; i++) {
+    sorted[bucketCell[bucket_of(itemKey[i])]++] = static_cast<uint32_t>(i);
+  }
+
+  // Group the cells sharing a bucket into runs (stable, buckets are tiny)
+  // and record every run as an occupied cell
+  for (uint32_t b = 0; b <= bucketMask; b++) {
+    bucketCell[b] = static_cast<uint32_t>(occupied.size());
+    uint32_t begin = bucketStart[b];
+    uint32_t end = begin + bucketCount[b];
+    for (uint32_t i = begin + 1; i < end; i++) {
+      uint32_t item = sorted[i];
+      uint32_t j = i;
+      while (j > begin && itemKey[sorted[j - 1]] > itemKey[item]) {
+        sorted[j] = sorted[j - 1];
+        j--;
+      }
+      sorted[j] = item;
+    }
+    for (uint32_t i = begin; i < end;) {
+      uint64_t key = itemKey[sorted[i]];
+      uint32_t runEnd = i + 1;
+      while (runEnd < end && itemKey[sorted[runEnd]] == key) {
+        runEnd++;
+      }
+      occupied.push_back(Cell{static_cast<int32_t>(key >> 32),
+                              static_cast<int32_t>(key & 0xffffffffu), i,
+                              runEnd - i});
+      i = runEnd;
+    }
+  }
+  bucketCell[bucketMask + 1] = static_cast<uint32_t>(occupied.size());
+}
+
+const SpatialGrid::Cell* SpatialGrid::find_cell(int x, int z) const {
+  if (occupied.empty()) {
+    return nullptr;
+  }
+  uint32_t b = bucket_of(pack_key(x, z));
+  for (uint32_t c = bucketCell[b]; c < bucketCell[b + 1]; c++) {
+    if (occupied[c].x == x && occupied[c].z == z) {
+      return &occupied[c];
+    }
+  }
+  return nullptr;
+}
@@ -1,6 +1,13 @@
 #include "terrain.hpp"
 #include <scoped_allocator>
 
+#include "profiler.hpp"
+
+// Grass is cosmetic, so a fixed seed: the same meadow every run
+const uint64_t GRASS_SEED = 0;
+// Resident grass chunks at most: about 430 chunks, 169 of them in use
+const size_t GRASS_MEMORY_BUDGET = 16 << 20;
+
 Blade::Blade(Shader shadowShader, vec3 pos) : pos(pos) {
   model = LoadModel("resources/models/grass_blade.glb");
   if (model.meshCount == 0) {
@@ -10,10 +17,7 @@ Blade::Blade(Shader shadowShader, vec3 pos) : pos(pos) {
 }
 
 Terrain::Terrain(Shader shadowShader)
-    : blade(shadowShader, make_vec3(0.0f)),
-      bladeCount(bladeCount),
-      windTime(0.0f) {
-  bladeCount = 60000;
+    : blade(shadowShader, make_vec3(0.0f)), windTime(0.0f) {
   Shader instancedShader =
       LoadShader("resources/shaders/grass.vs", "resources/shaders/grass.fs");
   instancedShader.locs[SHADER_LOC_MATRIX_MODEL] =
@@ -25,39 +29,51 @@ Terrain::Terrain(Shader shadowShader)
   planeModel.materials[0].shader = shadowShader;
   blade.model.materials[0] = matInstances;
 
-  // Allocate memory for transformations
-  transforms = (Matrix*)RL_CALLOC(bladeCount, sizeof(Matrix));
+  // Chunks are built as the player gets near them, not up front
+  BoundingBox bladeBounds = {vec3(-0.1f, 0.0f, -0.1f), vec3(0.1f, 1.0f, 0.1f)};
+  if (blade.model.meshCount > 0) {
+    bladeBounds = GetMeshBoundingBox(blade.model.meshes[0]);
+  }
+  streamer = std::make_unique<TerrainStreamer>(GRASS_SEED, bladeBounds,
+                                               GRASS_MEMORY_BUDGET);
+
+  grass = ShaderProgram(instancedShader);
+  windParams = grass.uniform("windParams");
+}
 
+void generate_blade_transforms(Matrix* transforms,
+                               int count,
+                               vec3 center,
+                               float halfSize,
+                               RandomStream& random) {
   // Add scale factor for blade size
   float bladeSizeMin = 1.3f;  // Minimum blade size (was implicitly 1.0)
   float bladeSizeMax = 1.5f;  // Maximum blade size
   float bladeVertical = 1.5f;
-  int area = 40;
 
-  for (int i = 0; i < bladeCount; i++) {
-    Vector3 position = (Vector3){GetRandomFloat(-area, area), 0.0f,
-                                 GetRandomFloat(-area, area)};
+  for (int i = 0; i < count; i++) {
+    Vector3 position =
+        (Vector3){center.x + random.uniform(-halfSize, halfSize), center.y,
+                  center.z + random.uniform(-halfSize, halfSize)};
     Matrix translation = MatrixTranslate(position.x, position.y, position.z);
 
     // Add random scaling to each blade
-    float randomSize = GetRandomFloat(bladeSizeMin, bladeSizeMax);
+    float randomSize = random.uniform(bladeSizeMin, bladeSizeMax);
     Matrix scale =
         MatrixScale(randomSize, randomSize * bladeVertical, randomSize);
 
     Vector3 axis = Vector3Normalize((Vector3){1.0, 0.0, 0.0});
-    float angle = GetRandomFloat(150, 180) * DEG2RAD;
+    float angle = random.uniform(150, 180) * DEG2RAD;
     Matrix rotation = MatrixRotate(axis, angle);
 
     // Combine all transformations: Scale -> Rotate -> Translate
     Matrix scaleRotate = MatrixMultiply(rotation, scale);
     transforms[i] = MatrixMultiply(scaleRotate, translation);
-
-    blade.model.materials[0].shader.locs[SHADER_LOC_VECTOR_VIEW] =
-        GetShaderLocation(blade.model.materials[0].shader, "windParams");
   }
 }
 
-void Terrain::update(GameState& GameState, float dt) {
+void Terrain::update(vec3 focus, float dt) {
+  streamer->update(focus);
   windTime += dt;
 
   // Update wind parameters in shader
@@ -65,39 +81,27 @@ void Terrain::update(GameState& GameState, float dt) {
   float windFrequency = 0.2f;  // How many waves across the field
   float windSpeed = 3.5f;      // How fast the wind moves
 
-  Vector4 windParams = {windStrength, windFrequency, windSpeed, windTime};
-
-  Shader shader = blade.model.materials[0].shader;
-
-  SetShaderValue(shader, shader.locs[SHADER_LOC_VECTOR_VIEW], &windParams,
-                 SHADER_UNIFORM_VEC4);
-
-  Vector3 cameraPos = GameState.camera.position;  // Or however you access it
-  Vector3 cameraDir =
-      Vector3Normalize(Vector3Subtract(GameState.camera.target, cameraPos));
-  float fovy = GameState.camera.fovy;           // Assuming you have this value
-  float screenWidth = GameState.screenWidth;    // Assuming you have this value
-  float screenHeight = GameState.screenHeight;  // Assuming you have this value
-
-  // Set uniforms
-  SetShaderValue(shader, GetShaderLocation(shader, "cameraPos"), &cameraPos,
-                 SHADER_UNIFORM_VEC3);
-  SetShaderValue(shader, GetShaderLocation(shader, "cameraDir"), &cameraDir,
-                 SHADER_UNIFORM_VEC3);
-  SetShaderValue(shader, GetShaderLocation(shader, "fovy"), &fovy,
-                 SHADER_UNIFORM_FLOAT);
-  SetShaderValue(shader, GetShaderLocation(shader, "screenWidth"), &screenWidth,
-                 SHADER_UNIFORM_FLOAT);
-  SetShaderValue(shader, GetShaderLocation(shader, "screenHeight"),
-                 &screenHeight, SHADER_UNIFORM_FLOAT);
+  grass.set(windParams,
+            Vector4{windStrength, windFrequency, windSpeed, windTime});
 }
 
-void Terrain::draw() {
-  // Draw the terrain (plane)
-  DrawModelEx(planeModel, (Vector3){0.0f, -0.5f, 0.0f}, Vector3Zero(), 0.0f,
-              (Vector3){80.0f, 1.0f, 80.0f}, (Color){53, 128, 42, 255});
-
-  // Then try instancing
-  DrawMeshInstanced(blade.model.meshes[0], blade.model.materials[0], transforms,
-                    bladeCount);
+void Terrain::draw(const Frustum& frustum, vec3 eye, float density) {
+  // The ground follows the active chunks, so it never runs out
+  const float groundSize =
+      (2 * TerrainStreamer::LOAD_RADIUS + 1) * TerrainStreamer::CHUNK_SIZE;
+  vec3 ground = streamer->active_center();
+  DrawModelEx(planeModel, (Vector3){ground.x, -0.5f, ground.z}, Vector3Zero(),
+              0.0f, (Vector3){groundSize, 1.0f, groundSize},
+              (Color){53, 128, 42, 255});
+
+  // Only the blades of visible chunks are submitted
+  visible.clear();
+  {
+    PROFILE_SCOPE("Grass cull");
+    streamer->cull(frustum, eye, density, visible);
+  }
+  if (!visible.empty()) {
+    DrawMeshInstanced(blade.model.meshes[0], blade.model.materials[0],
+                      visible.data(), static_cast<int>(visible.size()));
+  }
 }
@@ -0,0 +1,256 @@
+#include "terrain_streamer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "profiler.hpp"
+#include "terrain.hpp"
+
+// How far the wind can push a blade tip past its rest box
+const float GRASS_SWAY = 0.5f;
+
+static uint64_t chunk_key(ChunkCoord coord) {
+  return (static_cast<uint64_t>(static_cast<uint32_t>(coord.x)) << 32) |
+         static_cast<uint32_t>(coord.z);
+}
+
+static ChunkCoord chunk_containing(vec3 point) {
+  return ChunkCoord{
+      static_cast<int32_t>(
+          std::floor(point.x / TerrainStreamer::CHUNK_SIZE)),
+      static_cast<int32_t>(
+          std::floor(point.z / TerrainStreamer::CHUNK_SIZE))};
+}
+
+// Axis-aligned box around `box` once moved by `transform`
+static BoundingBox transform_box(const BoundingBox& box,
+                                 const Matrix& transform) {
+  BoundingBox result = {make_vec3(INFINITY), make_vec3(-INFINITY)};
+  for (int corner = 0; corner < 8; corner++) {
+    vec3 point((corner & 1) ? box.max.x : box.min.x,
+               (corner & 2) ? box.max.y : box.min.y,
+               (corner & 4) ? box.max.z : box.min.z);
+    point = Vector3Transform(point, transform);
+    result.min = Vector3Min(result.min, point);
+    result.max = Vector3Max(result.max, point);
+  }
+  return result;
+}
+
+GrassChunk generate_grass_chunk(uint64_t seed,
+                                ChunkCoord coord,
+                                const BoundingBox& bladeBounds) {
+  const float size = TerrainStreamer::CHUNK_SIZE;
+  const int count = TerrainStreamer::BLADES_PER_CHUNK;
+  GrassChunk chunk;
+  chunk.coord = coord;
+  chunk.blades.resize(count);
+  RandomStream random(seed, RandomDomain::GRASS,
+                      static_cast<uint32_t>(coord.x),
+                      static_cast<uint32_t>(coord.z));
+  vec3 middle((coord.x + 0.5f) * size, 0.0f, (coord.z + 0.5f) * size);
+  generate_blade_transforms(chunk.blades.data(), count, middle, size / 2.0f,
+                            random);
+
+  chunk.bounds = {make_vec3(INFINITY), make_vec3(-INFINITY)};
+  for (const Matrix& blade : chunk.blades) {
+    BoundingBox box = transform_box(bladeBounds, blade);
+    chunk.bounds.min = Vector3Min(chunk.bounds.min, box.min);
+    chunk.bounds.max = Vector3Max(chunk.bounds.max, box.max);
+  }
+  chunk.bounds.min = Vector3Subtract(chunk.bounds.min, make_vec3(GRASS_SWAY));
+  chunk.bounds.max = Vector3Add(chunk.bounds.max, make_vec3(GRASS_SWAY));
+  return chunk;
+}
+
+TerrainStreamer::TerrainStreamer(uint64_t seed,
+                                 const BoundingBox& bladeBounds,
+                                 size_t budgetBytes,
+                                 bool background)
+    : seed(seed),
+      bladeBounds(bladeBounds),
+      budgetBytes(budgetBytes),
+      background(background) {
+#if defined(__EMSCRIPTEN__)
+  // The web build has no threads; build inline
+  this->background = false;
+#endif
+  if (this->background) {
+    worker = std::thread(&TerrainStreamer::worker_loop, this);
+  }
+}
+
+TerrainStreamer::~TerrainStreamer() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  if (worker.joinable()) {
+    worker.join();
+  }
+}
+
+bool TerrainStreamer::is_active(ChunkCoord coord) const {
+  return std::abs(coord.x - center.x) <= LOAD_RADIUS &&
+         std::abs(coord.z - center.z) <= LOAD_RADIUS;
+}
+
+// Active chunks not resident yet, nearest first
+std::vector<ChunkCoord> TerrainStreamer::missing_chunks() const {
+  std::vector<ChunkCoord> missing;
+  for (int dz = -LOAD_RADIUS; dz <= LOAD_RADIUS; dz++) {
+    for (int dx = -LOAD_RADIUS; dx <= LOAD_RADIUS; dx++) {
+      ChunkCoord coord = {center.x + dx, center.z + dz};
+      if (cache.find(chunk_key(coord)) == cache.end()) {
+        missing.push_back(coord);
+      }
+    }
+  }
+  auto distance = [&](ChunkCoord c) {
+    return (c.x - center.x) * (c.x - center.x) +
+           (c.z - center.z) * (c.z - center.z);
+  };
+  std::stable_sort(missing.begin(), missing.end(),
+                   [&](ChunkCoord a, ChunkCoord b) {
+                     return distance(a) < distance(b);
+                   });
+  return missing;
+}
+
+void TerrainStreamer::adopt(GrassChunk chunk) {
+  const uint64_t key = chunk_key(chunk.coord);
+  if (cache.find(key) != cache.end()) {
+    return;  // Built twice across a change of center
+  }
+  residentBytes += chunk.blades.capacity() * sizeof(Matrix);
+  lru.push_front(key);
+  cache.emplace(key, Entry{std::move(chunk), lru.begin()});
+}
+
+// Move the active chunks to the front of the LRU list
+void TerrainStreamer::touch_active() {
+  for (int dz = -LOAD_RADIUS; dz <= LOAD_RADIUS; dz++) {
+    for (int dx = -LOAD_RADIUS; dx <= LOAD_RADIUS; dx++) {
+      auto it = cache.find(chunk_key({center.x + dx, center.z + dz}));
+      if (it != cache.end()) {
+        lru.splice(lru.begin(), lru, it->second.recent);
+      }
+    }
+  }
+}
+
+// Oldest first, skipping chunks still in use
+void TerrainStreamer::evict() {
+  auto recent = lru.end();
+  while (residentBytes > budgetBytes && recent != lru.begin()) {
+    --recent;
+    auto it = cache.find(*recent);
+    if (is_active(it->second.chunk.coord)) {
+      continue;
+    }
+    residentBytes -= it->second.chunk.blades.capacity() * sizeof(Matrix);
+    cache.erase(it);
+    recent = lru.erase(recent);
+    evicted++;
+  }
+}
+
+void TerrainStreamer::update(vec3 point) {
+  PROFILE_SCOPE("Terrain stream");
+  ChunkCoord middle = chunk_containing(point);
+  const bool moved =
+      !started || middle.x != center.x || middle.z != center.z;
+  center = middle;
+  started = true;
+  if (moved) {
+    touch_active();
+  }
+
+  if (!background) {
+    for (ChunkCoord coord : missing_chunks()) {
+      adopt(generate_grass_chunk(seed, coord, bladeBounds));
+      built++;
+    }
+    evict();
+    return;
+  }
+
+  bool queued = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (GrassChunk& chunk : finished) {
+      adopt(std::move(chunk));
+      built++;
+    }
+    finished.clear();
+    if (moved) {
+      // Chunks queued for an older center and not started are dropped
+      queue.clear();
+      for (ChunkCoord coord : missing_chunks()) {
+        if (!building || chunk_key(coord) != inFlight) {
+          queue.push_back(coord);
+        }
+      }
+      queued = !queue.empty();
+    }
+  }
+  if (queued) {
+    wake.notify_one();
+  }
+  evict();
+}
+
+void TerrainStreamer::cull(const Frustum& frustum,
+                           vec3 eye,
+                           float density,
+                           std::vector<Matrix>& out) const {
+  for (const auto& [key, entry] : cache) {
+    const GrassChunk& chunk = entry.chunk;
+    if (!frustum.intersects_box(chunk.bounds)) {
+      continue;
+    }
+    vec3 middle = Vector3Scale(Vector3Add(chunk.bounds.min, chunk.bounds.max),
+                               0.5f);
+    float t = Clamp((Vector3Distance(eye, middle) - LOD_NEAR) /
+                        (LOD_FAR - LOD_NEAR),
+                    0.0f, 1.0f);
+    float keep = density * Lerp(1.0f, LOD_FAR_DENSITY, t);
+    size_t count =
+        std::min(chunk.blades.size(),
+                 static_cast<size_t>(std::ceil(chunk.blades.size() * keep)));
+    out.insert(out.end(), chunk.blades.begin(),
+               chunk.blades.begin() + count);
+  }
+}
+
+vec3 TerrainStreamer::active_center() const {
+  return vec3((center.x + 0.5f) * CHUNK_SIZE, 0.0f,
+              (center.z + 0.5f) * CHUNK_SIZE);
+}
+
+void TerrainStreamer::worker_loop() {
+  PROFILE_THREAD("Terrain streamer");
+  std::unique_lock<std::mutex> lock(mutex);
+  for (;;) {
+    wake.wait(lock, [this] { return stopping || !queue.empty(); });
+    if (stopping) {
+      return;
+    }
+    ChunkCoord coord = queue.front();
+    queue.pop_front();
+    building = true;
+    inFlight = chunk_key(coord);
+    lock.unlock();
+
+    GrassChunk chunk;
+    {
+      PROFILE_SCOPE("Build grass chunk");
+      chunk = generate_grass_chunk(seed, coord, bladeBounds);
+    }
+
+    lock.lock();
+    building = false;
+    finished.push_back(std::move(chunk));
+  }
+}
@@ -0,0 +1,19 @@
+#include "tick_clock.hpp"
+
+#include <algorithm>
+
+TickClock::TickClock(float tickLength, int maxTicksPerFrame)
+    : tickLength(tickLength), maxTicksPerFrame(maxTicksPerFrame) {}
+
+int TickClock::advance(float frameTime) {
+  accumulator += std::max(frameTime, 0.0f);
+  int ticks = static_cast<int>(accumulator / tickLength);
+  accumulator -= tickLength * ticks;
+  // Float error can leave a hair over one tick behind; never report alpha 1
+  accumulator = std::min(std::max(accumulator, 0.0f), tickLength * 0.999f);
+  if (ticks > maxTicksPerFrame) {
+    droppedTicks += ticks - maxTicksPerFrame;
+    ticks = maxTicksPerFrame;
+  }
+  return ticks;
+}
@@ -0,0 +1,253 @@
+#include "tube_batch.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "rlgl.h"
+
+// Any unit vector at right angles to `direction`
+static vec3 any_perpendicular(vec3 direction) {
+  vec3 axis = std::fabs(direction.y) < 0.9f ? vec3(0.0f, 1.0f, 0.0f)
+                                            : vec3(1.0f, 0.0f, 0.0f);
+  return Vector3Normalize(Vector3CrossProduct(direction, axis));
+}
+
+void TubeBatch::clear() {
+  for (size_t i = 0; i < used; i++) {
+    pages[i].positions.clear();
+    pages[i].colors.clear();
+    pages[i].indices.clear();
+    pages[i].dirty = true;
+  }
+  used = 0;
+}
+
+TubeBatch::Page& TubeBatch::page_for(size_t vertices) {
+  if (used == 0 ||
+      pages[used - 1].positions.size() + vertices > PAGE_VERTICES) {
+    if (used == pages.size()) {
+      pages.emplace_back();
+    }
+    used++;
+  }
+  return pages[used - 1];
+}
+
+void TubeBatch::add(const vec3* points,
+                    size_t count,
+                    float radius,
+                    int sides,
+                    Color color) {
+  // Repeated points leave a segment with no direction
+  path.clear();
+  for (size_t i = 0; i < count; i++) {
+    if (path.empty() || Vector3DistanceSqr(points[i], path.back()) > 1e-8f) {
+      path.push_back(points[i]);
+    }
+  }
+  if (path.size() < 2) {
+    return;
+  }
+
+  ringX.resize(sides);
+  ringY.resize(sides);
+  for (int k = 0; k < sides; k++) {
+    float angle = 2.0f * PI * k / sides;
+    ringX[k] = std::cos(angle) * radius;
+    ringY[k] = std::sin(angle) * radius;
+  }
+
+  // A tube too long for one page carries on in the next from the point
+  // where it was cut
+  const size_t perPage = (PAGE_VERTICES - 2) / sides;
+  for (size_t start = 0; start + 1 < path.size(); start += perPage - 1) {
+    add_tube(&path[start], std::min(perPage, path.size() - start), sides,
+             color);
+  }
+}
+
+void TubeBatch::add_segment(vec3 start,
+                            vec3 end,
+                            float radius,
+                            int sides,
+                            Color color) {
+  const vec3 points[2] = {start, end};
+  add(points, 2, radius, sides, color);
+}
+
+void TubeBatch::add_tube(const vec3* points,
+                         size_t count,
+                         int sides,
+                         Color color) {
+  Page& page = page_for(count * sides + 2);
+  const size_t base = page.positions.size();
+
+  // One ring per point, square to the mean of the segments either side.
+  // Each ring's orientation carries over from the last, so the tube does
+  // not twist.
+  vec3 normal(0.0f, 0.0f, 0.0f);
+  for (size_t i = 0; i < count; i++) {
+    vec3 in = Vector3Normalize(i > 0 ? points[i] - points[i - 1]
+                                     : points[1] - points[0]);
+    vec3 out = i + 1 < count
+                   ? Vector3Normalize(points[i + 1] - points[i])
+                   : in;
+    vec3 tangent = Vector3Add(in, out);
+    tangent = Vector3LengthSqr(tangent) > 1e-6f ? Vector3Normalize(tangent)
+                                                : in;  // Doubles back
+    if (i > 0) {
+      float along = Vector3DotProduct(normal, tangent);
+      normal = Vector3Subtract(normal, Vector3Scale(tangent, along));
+    }
+    if (i == 0 || Vector3LengthSqr(normal) < 1e-6f) {
+      normal = any_perpendicular(tangent);
+    }
+    normal = Vector3Normalize(normal);
+    vec3 binormal = Vector3CrossProduct(tangent, normal);
+    for (int k = 0; k < sides; k++) {
+      page.positions.push_back(points[i] + normal * ringX[k] +
+                               binormal * ringY[k]);
+      page.colors.push_back(color);
+    }
+  }
+  const size_t startCap = page.positions.size();
+  page.positions.push_back(points[0]);
+  page.positions.push_back(points[count - 1]);
+  page.colors.push_back(color);
+  page.colors.push_back(color);
+
+  // Counter-clockwise seen from outside
+  auto triangle = [&](size_t a, size_t b, size_t c) {
+    page.indices.push_back(static_cast<unsigned short>(a));
+    page.indices.push_back(static_cast<unsigned short>(b));
+    page.indices.push_back(static_cast<unsigned short>(c));
+  };
+  for (size_t i = 0; i + 1 < count; i++) {
+    for (int k = 0; k < sides; k++) {
+      size_t a = base + i * sides + k;
+      size_t b = base + i * sides + (k + 1) % sides;
+      triangle(a, b, a + sides);
+      triangle(b, b + sides, a + sides);
+    }
+  }
+  const size_t last = base + (count - 1) * sides;
+  for (int k = 0; k < sides; k++) {
+    int next = (k + 1) % sides;
+    triangle(startCap, base + next, base + k);
+    triangle(startCap + 1, last + k, last + next);
+  }
+  page.dirty = true;
+}
+
+size_t TubeBatch::vertex_count() const {
+  size_t count = 0;
+  for (size_t i = 0; i < used; i++) {
+    count += pages[i].positions.size();
+  }
+  return count;
+}
+
+void TubeBatch::upload(Page& page) {
+  const size_t vertices = page.positions.size();
+  const size_t indices = page.indices.size();
+  if (vertices > page.vertexCapacity || indices > page.indexCapacity) {
+    // Grow geometrically so lengthening ropes reallocate rarely
+    unload(page);
+    page.vertexCapacity = std::min(vertices * 2, PAGE_VERTICES);
+    page.indexCapacity = indices * 2;
+    page.vao = rlLoadVertexArray();
+    rlEnableVertexArray(page.vao);
+    page.positionVbo = rlLoadVertexBuffer(
+        nullptr, static_cast<int>(page.vertexCapacity * sizeof(Vector3)),
+        true);
+    page.colorVbo = rlLoadVertexBuffer(
+        nullptr, static_cast<int>(page.vertexCapacity * sizeof(Color)), true);
+    page.indexEbo = rlLoadVertexBufferElement(
+        nullptr,
+        static_cast<int>(page.indexCapacity * sizeof(unsigned short)), true);
+    rlDisableVertexArray();
+  }
+  rlUpdateVertexBuffer(page.positionVbo, page.positions.data(),
+                       static_cast<int>(vertices * sizeof(Vector3)), 0);
+  rlUpdateVertexBuffer(page.colorVbo, page.colors.data(),
+                       static_cast<int>(vertices * sizeof(Color)), 0);
+  // Binding the index buffer changes the bound VAO, so bind ours
+  rlEnableVertexArray(page.vao);
+  rlUpdateVertexBufferElements(
+      page.indexEbo, page.indices.data(),
+      static_cast<int>(indices * sizeof(unsigned short)), 0);
+  rlDisableVertexArray();
+  page.dirty = false;
+}
+
+void TubeBatch::draw() {
+  if (used == 0) {
+    return;
+  }
+
+  const int* locs = rlGetShaderLocsDefault();
+  rlEnableShader(rlGetShaderIdDefault());
+  // The default shader multiplies texture, material and vertex color
+  float white[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+  rlSetUniform(locs[SHADER_LOC_COLOR_DIFFUSE], white, SHADER_UNIFORM_VEC4, 1);
+  rlActiveTextureSlot(0);
+  rlEnableTexture(rlGetTextureIdDefault());
+  Matrix modelView =
+      MatrixMultiply(rlGetMatrixTransform(), rlGetMatrixModelview());
+  rlSetUniformMatrix(locs[SHADER_LOC_MATRIX_MVP],
+                     MatrixMultiply(modelView, rlGetMatrixProjection()));
+
+  for (size_t i = 0; i < used; i++) {
+    Page& page = pages[i];
+    if (page.indices.empty()) {
+      continue;
+    }
+    if (page.dirty) {
+      upload(page);
+    }
+    // Attributes are pointed every draw, for drivers without VAOs
+    rlEnableVertexArray(page.vao);
+    rlEnableVertexBuffer(page.positionVbo);
+    rlSetVertexAttribute(locs[SHADER_LOC_VERTEX_POSITION], 3, RL_FLOAT, false,
+                         0, nullptr);
+    rlEnableVertexAttribute(locs[SHADER_LOC_VERTEX_POSITION]);
+    rlEnableVertexBuffer(page.colorVbo);
+    rlSetVertexAttribute(locs[SHADER_LOC_VERTEX_COLOR], 4, RL_UNSIGNED_BYTE,
+                         true, 0, nullptr);
+    rlEnableVertexAttribute(locs[SHADER_LOC_VERTEX_COLOR]);
+    rlDisableVertexAttribute(locs[SHADER_LOC_VERTEX_TEXCOORD01]);
+    rlEnableVertexBufferElement(page.indexEbo);
+    rlDrawVertexArrayElements(0, static_cast<int>(page.indices.size()),
+                              nullptr);
+  }
+
+  rlDisableVertexArray();
+  rlDisableVertexBuffer();
+  rlDisableVertexBufferElement();
+  rlDisableTexture();
+  rlDisableShader();
+}
+
+void TubeBatch::unload(Page& page) {
+  if (page.vao != 0) {
+    rlUnloadVertexArray(page.vao);
+  }
+  if (page.positionVbo != 0) {
+    rlUnloadVertexBuffer(page.positionVbo);
+    rlUnloadVertexBuffer(page.colorVbo);
+    rlUnloadVertexBuffer(page.indexEbo);
+  }
+  page.vao = 0;
+  page.positionVbo = 0;
+  page.colorVbo = 0;
+  page.indexEbo = 0;
+  page.vertexCapacity = 0;
+  page.indexCapacity = 0;
+  page.dirty = true;
+}
+
+void TubeBatch::unload() {
+  for (Page& page : pages) {
+    unload(page);
+  }
+}
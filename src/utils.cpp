@@ -2,32 +2,44 @@
 
 #include "animal.hpp"
 #include "buildings.hpp"
+#include "collectables.hpp"
+#include "fence_index.hpp"
+#include "pen_tracker.hpp"
+#include "physics.hpp"
 #include "player.hpp"
-#include "render_utils.hpp"
-#include "terrain.hpp"
+#include "rope_system.hpp"
 
-GameState::GameState(const rl::Shader& shadowShader,
-                     const int screenWidth,
-                     const int screenHeight)
+GameState::GameState(const int screenWidth,
+                     const int screenHeight,
+                     int threadCount,
+                     uint64_t seed)
     : screenWidth(screenWidth),
       screenHeight(screenHeight),
+      seed(seed),
+      spawnRandom(seed, RandomDomain::SPAWN),
       toggleFence(false),
       itemActive(0),
       coins(0),
-      camera(RenderUtils::SetupCamera()),
-      lightCam(RenderUtils::SetupLightCamera()),
-      terrain(std::make_unique<Terrain>(shadowShader)),
-      player(std::make_unique<Player>(vec3{0.0, 1.0, 0.0}, 0.2, shadowShader)),
-      animals(CreateAnimals(shadowShader, 1)),
+      camera{},
+      ropes(std::make_unique<RopeSystem>()),
+      player(std::make_unique<Player>(vec3{0.0, 1.0, 0.0}, 0.2, *ropes)),
+      animals(std::make_unique<AnimalPool>()),
       fence(std::make_unique<Fence>()),
-      pens() {
+      pens(),
+      fenceIndex(std::make_unique<FenceIndex>(GRID_SIZE)),
+      penTracker(std::make_unique<PenTracker>()),
+      coinPool(std::make_unique<CoinPool>()),
+      animalGrid(GRID_SIZE),
+      jobs(std::make_unique<JobSystem>(threadCount)) {
   // The unique_ptrs will automatically handle memory management
+  spawn_animals(*animals, spawnRandom, 1);
 }
 
-void GameState::addAnimal(const rl::Shader& shadowShader) {
-  animals.push_back(std::make_unique<Animal>(
-      vec3{GetRandomFloat(-25, 25), 1.0f, GetRandomFloat(-25, 25)}, 5.0f,
-      shadowShader));
+// Out of line so headers only need forward declarations of the members
+GameState::~GameState() = default;
+
+void GameState::addAnimal() {
+  spawn_animals(*animals, spawnRandom, 1);
 }
 
 float lerp_to(float position, float target, float rate) {
@@ -40,15 +52,13 @@ vec3 lerp3D(vec3 position, vec3 target, float rate) {
          (target - position) * rate;  // Lerp between vec3 position and target
 }
 
-float GetRandomFloat(float min, float max) {
-  return min +
-         (max - min) * ((float)GetRandomValue(0, RAND_MAX) / (float)RAND_MAX);
-}
-
 // Helper function to get the closest point on a line segment to a point
 vec3 GetClosestPointOnLineFromPoint(vec3 point, vec3 lineStart, vec3 lineEnd) {
   vec3 line = Vector3Subtract(lineEnd, lineStart);
   float lineLength = Vector3Length(line);
+  if (lineLength == 0.0f) {
+    return lineStart;  // Closed pens repeat their first post as an edge
+  }
   vec3 lineNormalized = Vector3Scale(line, 1.0f / lineLength);
 
   float t =
@@ -152,7 +162,8 @@ std::vector<std::array<vec2, 3>> triangulatePolygon(
 
 // Helper function to randomly select a triangle, weighted by area
 std::array<vec2, 3> selectRandomTriangle(
-    const std::vector<std::array<vec2, 3>>& triangles) {
+    const std::vector<std::array<vec2, 3>>& triangles,
+    RandomStream& random) {
   std::vector<float> areas;
   float totalArea = 0.0f;
 
@@ -164,7 +175,7 @@ std::array<vec2, 3> selectRandomTriangle(
   }
 
   // Select a triangle based on the area
-  float randomValue = static_cast<float>(rand()) / RAND_MAX * totalArea;
+  float randomValue = random.next_float() * totalArea;
   float cumulativeArea = 0.0f;
 
   for (size_t i = 0; i < triangles.size(); ++i) {
@@ -190,9 +201,10 @@ float calculateTriangleArea(const vec2& p1, const vec2& p2, const vec2& p3) {
 
 // Helper function to generate a random point within a triangle using
 // barycentric coordinates
-vec2 generateRandomPointInTriangle(const std::array<vec2, 3>& tri) {
-  float r1 = static_cast<float>(rand()) / RAND_MAX;
-  float r2 = static_cast<float>(rand()) / RAND_MAX;
+vec2 generateRandomPointInTriangle(const std::array<vec2, 3>& tri,
+                                   RandomStream& random) {
+  float r1 = random.next_float();
+  float r2 = random.next_float();
 
   // Adjust r1 and r2 to ensure the point is within the triangle
   if (r1 + r2 > 1.0f) {
@@ -207,8 +219,6 @@ vec2 generateRandomPointInTriangle(const std::array<vec2, 3>& tri) {
   return vec2{x, y};
 }
 
-void addAnimal(const rl::Shader& shadowShader) {}
-
 float normalizeAngle(float angle) {
   // Normalize angle to [-PI, PI]
   while (angle > PI)